@@ -0,0 +1,259 @@
+#include "game.h"
+#include "packed-state.h"
+#include "search-interface.h"
+#include "search-strategies.h"
+#include "zobrist.h"
+
+#include "argparse.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Microbenchmarks of the solver primitives. Every benchmark cycles through a
+// fixed pool of deals from seeded producers, so numbers are comparable across
+// commits. Output is one tab-separated line per benchmark:
+//   name  ns/op (mean over samples)  stddev  min  median  samples  ops/sample
+
+namespace {
+
+// keeps the compiler from discarding a computed value
+template <typename T>
+void keep(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Pool {
+    std::vector<GameState> deals;
+    std::vector<SearchState> states;
+    std::vector<PackedState> packed;
+    std::vector<PackedMove> first_moves;
+};
+
+Pool makePool(int nb_deals, int seed) {
+    Pool pool;
+    EasyProducer easy(seed, 30);
+    RandomProducer random(seed);
+    for (int i = 0; i < nb_deals; ++i) {
+        pool.deals.push_back(easy.produce());
+        pool.deals.push_back(random.produce());
+    }
+
+    for (const auto &gs : pool.deals) {
+        pool.states.emplace_back(gs);
+        pool.packed.emplace_back(gs);
+
+        MoveBuffer moves;
+        auto nb_moves = pool.states.back().actions(moves);
+        pool.first_moves.push_back(nb_moves > 0 ? moves[0] : PackedMove{});
+    }
+
+    return pool;
+}
+
+class Harness {
+public:
+    Harness(std::string filter, int nb_samples, std::chrono::microseconds sample_time) :
+        filter_(std::move(filter)), nb_samples_(nb_samples), sample_time_(sample_time) {}
+
+    // op(i) performs a single operation, i counts up from zero
+    void run(const std::string &name, const std::function<void(size_t)> &op) {
+        if (name.find(filter_) == std::string::npos)
+            return;
+
+        auto ops_per_sample = calibrate_(op);
+
+        std::vector<double> ns_per_op;
+        size_t i = 0;
+        for (int sample = 0; sample < nb_samples_; ++sample) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t n = 0; n < ops_per_sample; ++n)
+                op(i++);
+            std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - start;
+            ns_per_op.push_back(took.count() / ops_per_sample);
+        }
+
+        auto mean = std::accumulate(ns_per_op.begin(), ns_per_op.end(), 0.0) / ns_per_op.size();
+        double sq_dev = 0.0;
+        for (auto x : ns_per_op)
+            sq_dev += (x - mean) * (x - mean);
+        auto stddev = ns_per_op.size() > 1 ? std::sqrt(sq_dev / (ns_per_op.size() - 1)) : 0.0;
+
+        std::sort(ns_per_op.begin(), ns_per_op.end());
+        auto median = ns_per_op[ns_per_op.size() / 2];
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << name << "\t" << mean << "\t" << stddev << "\t"
+                  << ns_per_op.front() << "\t" << median << "\t"
+                  << nb_samples_ << "\t" << ops_per_sample << "\n" << std::flush;
+    }
+
+private:
+    // doubles the batch until one batch takes at least a sample's time
+    size_t calibrate_(const std::function<void(size_t)> &op) const {
+        size_t ops = 1;
+        while (true) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t n = 0; n < ops; ++n)
+                op(n);
+            auto took = std::chrono::steady_clock::now() - start;
+            if (took >= sample_time_ || ops >= (size_t{1} << 30))
+                return ops;
+            ops *= 2;
+        }
+    }
+
+    std::string filter_;
+    int nb_samples_;
+    std::chrono::microseconds sample_time_;
+};
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    argparse::ArgumentParser parser("FreeCell@SUI bench");
+    parser.add_argument("filter").default_value(std::string(""));
+    parser.add_argument("--samples").default_value(20).scan<'d', int>();
+    parser.add_argument("--sample-ms").default_value(10).scan<'d', int>();
+    parser.add_argument("--deals").default_value(32).scan<'d', int>();
+    parser.add_argument("--seed").default_value(1).scan<'d', int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error &err) {
+        std::cerr << err.what() << "\n";
+        std::cerr << parser;
+        std::exit(2);
+    }
+
+    const auto seed = parser.get<int>("--seed");
+    const auto pool = makePool(parser.get<int>("--deals"), seed);
+    const auto nb = pool.deals.size();
+
+    Harness bench(
+        parser.get<std::string>("filter"),
+        parser.get<int>("--samples"),
+        std::chrono::milliseconds(parser.get<int>("--sample-ms"))
+    );
+
+    std::cout << "# benchmark\tns/op\tstddev\tmin\tmedian\tsamples\tops/sample\n";
+
+    bench.run("producer/easy", [producer = EasyProducer(seed, 30)](size_t) mutable {
+        keep(producer.produce());
+    });
+    bench.run("producer/random", [producer = RandomProducer(seed)](size_t) mutable {
+        keep(producer.produce());
+    });
+
+    bench.run("game_state/copy", [&](size_t i) {
+        GameState copy(pool.deals[i % nb]);
+        keep(copy);
+    });
+    bench.run("game_state/equal", [&](size_t i) {
+        keep(pool.deals[i % nb] == pool.deals[(i + 1) % nb]);
+    });
+
+    // every (non-home, any) pair of locations of a deal, through CardStorage
+    // pointers and through the statically dispatched concrete types
+    bench.run("card_storage/move_legal_virtual", [&](size_t i) {
+        const auto &gs = pool.deals[i % nb];
+        int nb_legal = 0;
+        for (const CardStorage *from : gs.non_homes) {
+            for (const CardStorage *to : gs.all_storage)
+                nb_legal += moveLegal(from, to);
+        }
+        keep(nb_legal);
+    });
+    bench.run("card_storage/move_legal_static", [&](size_t i) {
+        const auto &gs = pool.deals[i % nb];
+        int nb_legal = 0;
+        auto legal_from = [&](const auto &froms) {
+            for (const auto &from : froms) {
+                for (const auto &to : gs.free_cells)
+                    nb_legal += moveLegal(&from, &to);
+                for (const auto &to : gs.stacks)
+                    nb_legal += moveLegal(&from, &to);
+                for (const auto &to : gs.homes)
+                    nb_legal += moveLegal(&from, &to);
+            }
+        };
+        legal_from(gs.free_cells);
+        legal_from(gs.stacks);
+        keep(nb_legal);
+    });
+    // a copy of the deal, then a card from each of the first stacks to a free cell
+    bench.run("card_storage/move_virtual", [&](size_t i) {
+        GameState copy(pool.deals[i % nb]);
+        for (int j = 0; j < nb_freecells; ++j)
+            move(copy.non_homes[nb_freecells + j], copy.non_homes[j]);
+        keep(copy);
+    });
+    bench.run("card_storage/move_static", [&](size_t i) {
+        GameState copy(pool.deals[i % nb]);
+        for (int j = 0; j < nb_freecells; ++j)
+            move(&copy.stacks[j], &copy.free_cells[j]);
+        keep(copy);
+    });
+
+    bench.run("search_state/copy", [&](size_t i) {
+        SearchState copy(pool.states[i % nb]);
+        keep(copy);
+    });
+    bench.run("search_state/equal", [&](size_t i) {
+        keep(pool.states[i % nb] == pool.states[(i + 1) % nb]);
+    });
+    bench.run("search_state/actions", [&](size_t i) {
+        MoveBuffer moves;
+        keep(pool.states[i % nb].actions(moves));
+        keep(moves);
+    });
+    bench.run("search_state/actions_vector", [&](size_t i) {
+        keep(pool.states[i % nb].actions());
+    });
+    // with automatic home moves and incremental keys
+    bench.run("search_state/execute", [&](size_t i) {
+        SearchState copy(pool.states[i % nb]);
+        keep(copy.execute(pool.first_moves[i % nb]));
+        keep(copy);
+    });
+    auto scratch = pool.states;
+    bench.run("search_state/make_unmake", [&](size_t i) {
+        UndoRecord undo;
+        auto &state = scratch[i % nb];
+        if (state.make(pool.first_moves[i % nb], &undo))
+            state.unmake(undo);
+        keep(state);
+    });
+    // the bare move, no automatic moves
+    bench.run("packed_state/move", [&](size_t i) {
+        PackedState copy(pool.packed[i % nb]);
+        auto move = pool.first_moves[i % nb];
+        copy.move(move.from(), move.to());
+        keep(copy);
+    });
+
+    bench.run("hash/zobrist", [&](size_t i) {
+        keep(zobristKey(pool.packed[i % nb]));
+    });
+    bench.run("hash/canonical", [&](size_t i) {
+        keep(canonicalKey(pool.packed[i % nb]));
+    });
+
+    OufOfHome_Pseudo nb_not_home;
+    StudentHeuristic student;
+    bench.run("heuristic/nb_not_home", [&](size_t i) {
+        keep(compute_heuristic(pool.states[i % nb], nb_not_home));
+    });
+    bench.run("heuristic/student", [&](size_t i) {
+        keep(compute_heuristic(pool.states[i % nb], student));
+    });
+
+    return 0;
+}
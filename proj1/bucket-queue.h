@@ -0,0 +1,71 @@
+#ifndef BUCKET_QUEUE_H
+#define BUCKET_QUEUE_H
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Open list for integer costs: one bucket per f, inside it one LIFO
+// stack per h. pop() returns an item of the lowest f, among those the
+// lowest h, among those the one pushed last. Push is O(1), pop is
+// amortized O(1) as long as f and h stay small, which they do for
+// move counts and card counts.
+template <typename T>
+class BucketQueue {
+public:
+    void push(int f, int h, const T &item) {
+        assert(f >= 0 && h >= 0);
+        if (static_cast<std::size_t>(f) >= buckets_.size())
+            buckets_.resize(f + 1);
+        auto &bucket = buckets_[f];
+        if (static_cast<std::size_t>(h) >= bucket.size())
+            bucket.resize(h + 1);
+
+        bucket[h].push_back(item);
+        if (size_ == 0 || f < min_f_) {
+            min_f_ = f;
+            min_h_ = h;
+        } else if (f == min_f_ && h < min_h_) {
+            min_h_ = h;
+        }
+        ++size_;
+    }
+
+    // the queue must not be empty
+    T pop() {
+        assert(size_ > 0);
+        while (true) {
+            auto &bucket = buckets_[min_f_];
+            for (; min_h_ < static_cast<int>(bucket.size()); ++min_h_) {
+                auto &stack = bucket[min_h_];
+                if (!stack.empty()) {
+                    T item = stack.back();
+                    stack.pop_back();
+                    --size_;
+                    return item;
+                }
+            }
+            ++min_f_;
+            min_h_ = 0;
+        }
+    }
+
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+
+    // drops all items, keeps the buckets allocated
+    void clear() {
+        for (auto &bucket : buckets_)
+            for (auto &stack : bucket)
+                stack.clear();
+        size_ = 0;
+    }
+
+private:
+    std::vector<std::vector<std::vector<T>>> buckets_;
+    std::size_t size_ = 0;
+    int min_f_ = 0;
+    int min_h_ = 0;
+};
+
+#endif
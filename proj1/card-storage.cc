@@ -1,5 +1,9 @@
 #include "card-storage.h"
 
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<InlineCards<max_stack_size>>);
+
 bool operator== (const std::optional<Card> &lhs, const std::optional<Card> rhs) {
     if (lhs.has_value() && rhs.has_value()) {
         return *lhs == *rhs;
@@ -10,32 +14,16 @@ bool operator== (const std::optional<Card> &lhs, const std::optional<Card> rhs)
     }
 }
 
-bool HomeDestination::canSitOn(const Card &base, const Card &candidate) {
-	return candidate.color == base.color && candidate.value == base.value + 1;
-}
-
-bool HomeDestination::canAccept(const Card & card) const {
-    if (storage_.size() == 0)
-		return card.value == 1;
-    else
-		return canSitOn(*topCard(), card);
-}
-
 bool HomeDestination::acceptCard(const Card & card) {
 	auto move_ok = canAccept(card);
-	if (move_ok) 
-		storage_.push_back(card);
+	if (move_ok) {
+		color_ = card.color;
+		rank_ = card.value;
+	}
 
 	return move_ok;
 }
 
-const std::optional<Card> HomeDestination::topCard() const {
-	if (storage_.size() > 0)
-		return storage_.back();
-	else
-		return std::nullopt;
-}
-
 bool operator< (const HomeDestination &lhs, const HomeDestination &rhs) {
     return lhs.topCard() < rhs.topCard();
 }
@@ -54,13 +42,14 @@ bool operator== (const WorkStack &lhs, const WorkStack &rhs) {
 
 
 std::optional<Card> HomeDestination::getCard() {
-	auto card = storage_.back();
-	storage_.pop_back();
+	auto card = topCard();
+	if (rank_ > 0)
+		--rank_;
 	return card;
 }
 
 std::ostream& operator<< (std::ostream& os, const HomeDestination & hd) {
-	if (hd.storage_.size() == 0)
+	if (hd.rank_ == 0)
         os << "_"; 
     else
         os << *hd.topCard();
@@ -69,10 +58,6 @@ std::ostream& operator<< (std::ostream& os, const HomeDestination & hd) {
 }
 
 
-bool FreeCell::canAccept([[maybe_unused]] const Card & card) const {
-	return !cell_.has_value();
-}
-
 bool FreeCell::acceptCard(const Card & card) {
 	auto move_ok = canAccept(card);
     if (move_ok)
@@ -90,10 +75,6 @@ FreeCell & FreeCell::operator=(FreeCell &other) {
 	return *this;
 }
 
-const std::optional<Card> FreeCell::topCard() const {
-	return cell_;
-}
-
 std::optional<Card> FreeCell::getCard() {
 	auto card = std::move(cell_);
 	cell_.reset();
@@ -119,20 +100,6 @@ std::ostream& operator<< (std::ostream& os, const FreeCell & fc) {
     return os;
 }
 
-bool WorkStack::canSitOn(const Card &base, const Card &candidate) {
-	bool oppposing_render_color = render_color_map.at(candidate.color) != render_color_map.at(base.color);
-	bool one_less = candidate.value == base.value - 1;
-	return oppposing_render_color && one_less;
-}
-
-
-bool WorkStack::canAccept(const Card & card) const {
-    if (storage_.size() == 0)
-        return true;
-    else
-		return canSitOn(*topCard(), card);
-}
-
 bool WorkStack::acceptCard(const Card & card) {
 	auto move_ok = canAccept(card);
 	if (move_ok) 
@@ -141,13 +108,6 @@ bool WorkStack::acceptCard(const Card & card) {
 	return move_ok;
 }
 
-const std::optional<Card> WorkStack::topCard() const {
-	if (storage_.size() > 0)
-		return storage_.back();
-	else
-		return std::nullopt;
-}
-
 
 std::optional<Card> WorkStack::getCard() {
 	if (storage_.size() > 0) {
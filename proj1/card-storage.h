@@ -3,10 +3,84 @@
 
 #include "card.h"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
 #include <string>
 #include <vector>
 #include <optional>
 
+// Dealt cascades hold at most 8 cards before the search starts
+// (7 in a random deal, at most 7 + 1 forced in an easy one).
+// Legal moves can only add an alternating run below the top card, i.e. 12 more.
+inline constexpr int max_stack_size = 20;
+
+// A fixed-capacity stack of cards kept inline as card indices, so copying
+// it is a plain byte copy. Reading an element yields a Card by value.
+template <std::size_t Capacity>
+class InlineCards {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Card;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Card;
+
+        explicit const_iterator(const CardIndex *pos) : pos_(pos) {}
+
+        Card operator*() const { return {cardColor(*pos_), cardValue(*pos_)}; }
+        const_iterator &operator++() { ++pos_; return *this; }
+        const_iterator operator+(std::ptrdiff_t n) const { return const_iterator(pos_ + n); }
+        bool operator==(const const_iterator &other) const { return pos_ == other.pos_; }
+        bool operator!=(const const_iterator &other) const { return pos_ != other.pos_; }
+
+    private:
+        const CardIndex *pos_;
+    };
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    Card operator[](std::size_t i) const { return *const_iterator(cards_.data() + i); }
+    Card back() const {
+        assert(size_ > 0);
+        return (*this)[size_ - 1];
+    }
+
+    const_iterator begin() const { return const_iterator(cards_.data()); }
+    const_iterator end() const { return const_iterator(cards_.data() + size_); }
+
+    void push_back(const Card &card) {
+        assert(size_ < Capacity);
+        cards_[size_++] = card.index();
+    }
+
+    void pop_back() {
+        assert(size_ > 0);
+        --size_;
+    }
+
+    // the index order matches operator<(Card, Card)
+    friend bool operator<(const InlineCards &lhs, const InlineCards &rhs) {
+        return std::lexicographical_compare(
+            lhs.cards_.begin(), lhs.cards_.begin() + lhs.size_,
+            rhs.cards_.begin(), rhs.cards_.begin() + rhs.size_
+        );
+    }
+
+    friend bool operator==(const InlineCards &lhs, const InlineCards &rhs) {
+        return lhs.size_ == rhs.size_ && std::equal(lhs.cards_.begin(), lhs.cards_.begin() + lhs.size_, rhs.cards_.begin());
+    }
+
+private:
+    std::array<CardIndex, Capacity> cards_{};
+    std::uint8_t size_ = 0;
+};
+
 
 class CardStorage {
 public:
@@ -18,7 +92,7 @@ public:
 };
 
 
-class HomeDestination : public CardStorage {
+class HomeDestination final : public CardStorage {
 public:
 	static bool canSitOn(const Card &base, const Card &candidate);
 	bool canAccept(const Card & card) const override;
@@ -29,14 +103,17 @@ public:
     friend std::ostream& operator<< (std::ostream& os, const HomeDestination & hd) ;
 
 private:
-    std::vector<Card> storage_;
+    // a home only ever exposes its top card: its color and rank,
+    // rank 0 meaning an empty home
+    Color color_ = Color::Heart;
+    std::uint8_t rank_ = 0;
 };
 
 bool operator< (const HomeDestination &lhs, const HomeDestination &rhs) ;
 bool operator== (const HomeDestination &lhs, const HomeDestination &rhs) ;
 
 
-class WorkStack : public CardStorage {
+class WorkStack final : public CardStorage {
 public:
 	static bool canSitOn(const Card &base, const Card &candidate);
 	bool canAccept(const Card & card) const override;
@@ -55,7 +132,7 @@ public:
     friend bool operator== (const WorkStack &lhs, const WorkStack &rhs) ;
 
 private:
-    std::vector<Card> storage_;
+    InlineCards<max_stack_size> storage_;
 
 public:
     const decltype(storage_) &storage() const {return storage_;}
@@ -65,7 +142,7 @@ bool operator< (const WorkStack &lhs, const WorkStack &rhs) ;
 bool operator== (const WorkStack &lhs, const WorkStack &rhs) ;
 
 
-class FreeCell : public CardStorage {
+class FreeCell final : public CardStorage {
 public:
 	FreeCell & operator=(FreeCell &other) ;
 
@@ -83,4 +160,53 @@ bool operator== (const FreeCell &lhs, const FreeCell &rhs) ;
 
 std::ostream& operator<< (std::ostream& os, const FreeCell & fc) ;
 
+
+// The storage classes are final and the accessors below are inline,
+// so calls made through a concrete type bind statically and inline;
+// only calls through CardStorage go through the vtable.
+
+inline bool HomeDestination::canSitOn(const Card &base, const Card &candidate) {
+	return cardSitsOnHome(base.index(), candidate.index());
+}
+
+inline bool HomeDestination::canAccept(const Card & card) const {
+    if (rank_ == 0)
+		return card.value == 1;
+    else
+		return cardSitsOnHome(cardIndex(color_, rank_), card.index());
+}
+
+inline const std::optional<Card> HomeDestination::topCard() const {
+	if (rank_ > 0)
+		return Card{color_, rank_};
+	else
+		return std::nullopt;
+}
+
+inline bool WorkStack::canSitOn(const Card &base, const Card &candidate) {
+	return cardSitsOnStack(base.index(), candidate.index());
+}
+
+inline bool WorkStack::canAccept(const Card & card) const {
+    if (storage_.size() == 0)
+        return true;
+    else
+		return canSitOn(storage_.back(), card);
+}
+
+inline const std::optional<Card> WorkStack::topCard() const {
+	if (storage_.size() > 0)
+		return storage_.back();
+	else
+		return std::nullopt;
+}
+
+inline bool FreeCell::canAccept([[maybe_unused]] const Card & card) const {
+	return !cell_.has_value();
+}
+
+inline const std::optional<Card> FreeCell::topCard() const {
+	return cell_;
+}
+
 #endif
@@ -2,6 +2,11 @@
 
 #include <cassert>
 
+static_assert(cardSitsOnStack(cardIndex(Color::Spade, 8), cardIndex(Color::Heart, 7)));
+static_assert(!cardSitsOnStack(cardIndex(Color::Spade, 8), cardIndex(Color::Club, 7)));
+static_assert(cardSitsOnHome(cardIndex(Color::Club, 1), cardIndex(Color::Club, 2)));
+static_assert(!cardSitsOnHome(cardIndex(Color::Heart, king_value), cardIndex(Color::Diamond, 1)));
+
 const std::map<Color, std::string> color_map{
 	{Color::Heart, "h"},
 	{Color::Diamond, "d"},
@@ -37,7 +42,7 @@ std::ostream& operator<< (std::ostream& os, const Card & card) {
 	} else if (card.value == 13) {
 		os << "K";
 	}
-	os << color_map.at(card.color);
+	os << colorSymbol(card.color);
 	return os;
 }
 
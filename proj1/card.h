@@ -2,6 +2,8 @@
 #define CARD_H
 
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <map>
 #include <vector>
@@ -18,9 +20,78 @@ extern const std::map<Color, RenderColor> render_color_map;
 
 inline constexpr int king_value = 13;
 
+// Compile-time card model. A card is indexed by six bits,
+// color * king_value + (value - 1), so the index order matches
+// operator<(Card, Card). Per-card attributes and the "can sit on"
+// relations are tables built at compile time: legality checks are
+// a load or a bit test instead of map lookups.
+using CardIndex = std::uint8_t;
+inline constexpr int nb_card_indices = king_value * 4;
+
+namespace card_tables {
+
+struct Tables {
+	std::array<Color, nb_card_indices> color;
+	std::array<std::uint8_t, nb_card_indices> value;
+	std::array<bool, nb_card_indices> red;
+	// bit c of stack_bases[b] is set iff card c may sit on card b in a cascade
+	std::array<std::uint64_t, nb_card_indices> stack_bases;
+	// bit c of home_bases[b] is set iff card c may follow card b home
+	std::array<std::uint64_t, nb_card_indices> home_bases;
+};
+
+// relies on the declaration order of Color: Heart, Diamond, Club, Spade
+constexpr Tables build() {
+	Tables t{};
+	for (int c = 0; c < nb_card_indices; ++c) {
+		t.color[c] = static_cast<Color>(c / king_value);
+		t.value[c] = static_cast<std::uint8_t>(c % king_value + 1);
+		t.red[c] = c / king_value <= static_cast<int>(Color::Diamond);
+	}
+	for (int b = 0; b < nb_card_indices; ++b) {
+		for (int c = 0; c < nb_card_indices; ++c) {
+			if (t.value[c] + 1 == t.value[b] && t.red[c] != t.red[b])
+				t.stack_bases[b] |= std::uint64_t{1} << c;
+			if (t.color[c] == t.color[b] && t.value[c] == t.value[b] + 1)
+				t.home_bases[b] |= std::uint64_t{1} << c;
+		}
+	}
+	return t;
+}
+
+inline constexpr Tables tables = build();
+
+inline constexpr std::array<char, 4> color_symbols{'h', 'd', 'c', 's'};
+
+} // namespace card_tables
+
+constexpr CardIndex cardIndex(Color color, int value) {
+	return static_cast<CardIndex>(static_cast<int>(color) * king_value + value - 1);
+}
+
+constexpr Color cardColor(CardIndex card) { return card_tables::tables.color[card]; }
+constexpr int cardValue(CardIndex card) { return card_tables::tables.value[card]; }
+constexpr bool cardIsRed(CardIndex card) { return card_tables::tables.red[card]; }
+
+constexpr bool cardSitsOnStack(CardIndex base, CardIndex candidate) {
+	return (card_tables::tables.stack_bases[base] >> candidate) & 1;
+}
+
+constexpr bool cardSitsOnHome(CardIndex base, CardIndex candidate) {
+	return (card_tables::tables.home_bases[base] >> candidate) & 1;
+}
+
+constexpr RenderColor renderColor(Color color) {
+	return static_cast<int>(color) <= static_cast<int>(Color::Diamond) ? RenderColor::Red : RenderColor::Black;
+}
+
+constexpr char colorSymbol(Color color) { return card_tables::color_symbols[static_cast<int>(color)]; }
+
 struct Card {
 	Card(Color col, int val);
 
+	CardIndex index() const { return cardIndex(color, value); }
+
 	const Color color;
 	const int value;
 };
@@ -0,0 +1,206 @@
+#include "corpus.h"
+
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// changes of a metric below this are never flagged
+constexpr double change_threshold = 0.05;
+// Added to both sides of each per-deal ratio, so that changes within the
+// measurement noise of tiny values do not show up as large ratios.
+constexpr double count_floor = 1.0;
+constexpr double time_floor_us = 1000.0;
+constexpr double rss_floor_bytes = 64.0 * 1024 * 1024;
+
+// a change is significant when the mean of the per-deal log ratios is
+// this many standard errors away from zero (about 95 % two-sided)
+constexpr double t_critical = 2.0;
+
+const char *const results_header = "set\tdeal\tsolved\tlength\texpanded\ttime_us\tpeak_rss";
+
+struct PairedChange {
+    std::size_t nb_deals = 0;
+    // geometric mean of current / baseline
+    double ratio = 1.0;
+    double t = 0.0;
+};
+
+PairedChange pairedChange(const std::vector<double> &log_ratios) {
+    PairedChange change;
+    change.nb_deals = log_ratios.size();
+    if (log_ratios.empty())
+        return change;
+
+    double mean = 0.0;
+    for (auto r : log_ratios)
+        mean += r;
+    mean /= log_ratios.size();
+    change.ratio = std::exp(mean);
+
+    // rounding leftovers of identical values
+    if (log_ratios.size() < 2 || std::abs(mean) < 1e-9)
+        return change;
+
+    double sq_dev = 0.0;
+    for (auto r : log_ratios)
+        sq_dev += (r - mean) * (r - mean);
+    auto std_error = std::sqrt(sq_dev / (log_ratios.size() - 1) / log_ratios.size());
+
+    if (std_error > 0.0)
+        change.t = mean / std_error;
+    else
+        change.t = mean > 0.0 ? INFINITY : -INFINITY;
+    return change;
+}
+
+// larger is worse for every compared metric
+const char *verdict(const PairedChange &change) {
+    if (change.nb_deals < 2)
+        return "too few deals";
+    if (change.ratio > 1.0 + change_threshold && change.t > t_critical)
+        return "REGRESSION";
+    if (change.ratio < 1.0 / (1.0 + change_threshold) && change.t < -t_critical)
+        return "improvement";
+    return "ok";
+}
+
+} // namespace
+
+CorpusSet CorpusSet::forDifficulty(int difficulty) {
+    if (difficulty < 0)
+        return {"random", -1};
+    else
+        return {"easy-" + std::to_string(difficulty), difficulty};
+}
+
+std::unique_ptr<InitialStateProducerItf> CorpusSet::producer(int seed) const {
+    if (difficulty < 0)
+        return std::make_unique<RandomProducer>(seed);
+    else
+        return std::make_unique<EasyProducer>(seed, difficulty);
+}
+
+std::vector<CorpusSet> corpusSets(const std::string &corpus_name) {
+    std::vector<CorpusSet> easy{CorpusSet::forDifficulty(10), CorpusSet::forDifficulty(20), CorpusSet::forDifficulty(35)};
+    auto random = CorpusSet::forDifficulty(-1);
+
+    if (corpus_name == "easy") {
+        return easy;
+    } else if (corpus_name == "random") {
+        return {random};
+    } else if (corpus_name == "standard") {
+        easy.push_back(random);
+        return easy;
+    } else {
+        throw std::invalid_argument("Unknown corpus '" + corpus_name + "', supported are: easy, random, standard");
+    }
+}
+
+void writeCorpusResults(std::ostream &os, const std::vector<CorpusRecord> &records) {
+    os << results_header << "\n";
+    for (const auto &[set, record] : records) {
+        os << set << "\t" << record.deal << "\t" << record.solved << "\t" <<
+            record.solution_length << "\t" << record.expanded << "\t" <<
+            record.time.count() << "\t" << record.peak_rss << "\n";
+    }
+}
+
+std::vector<CorpusRecord> readCorpusResults(std::istream &is) {
+    std::string line;
+    if (!std::getline(is, line) || line != results_header)
+        throw std::runtime_error("Not a corpus results file, expected the header: " + std::string(results_header));
+
+    std::vector<CorpusRecord> records;
+    for (int line_nb = 2; std::getline(is, line); ++line_nb) {
+        if (line.empty())
+            continue;
+
+        std::istringstream fields(line);
+        CorpusRecord entry;
+        long long time_us;
+        fields >> entry.set >> entry.record.deal >> entry.record.solved >> entry.record.solution_length >>
+            entry.record.expanded >> time_us >> entry.record.peak_rss;
+        if (!fields)
+            throw std::runtime_error("Malformed corpus results on line " + std::to_string(line_nb));
+        entry.record.time = std::chrono::microseconds(time_us);
+        records.push_back(std::move(entry));
+    }
+
+    return records;
+}
+
+int compareToBaseline(std::ostream &os, const std::vector<CorpusRecord> &baseline, const std::vector<CorpusRecord> &current) {
+    std::map<std::pair<std::string, unsigned long>, const DealRecord *> baseline_by_deal;
+    for (const auto &[set, record] : baseline)
+        baseline_by_deal[{set, record.deal}] = &record;
+
+    // sets in the order of the current run
+    std::vector<std::string> sets;
+    for (const auto &entry : current) {
+        if (sets.empty() || sets.back() != entry.set)
+            sets.push_back(entry.set);
+    }
+
+    int nb_regressions = 0;
+    os << std::fixed << std::setprecision(3);
+    for (const auto &set : sets) {
+        std::size_t nb_matched = 0, nb_unmatched = 0, solved_before = 0, solved_now = 0, nb_lost = 0, nb_gained = 0;
+        std::vector<double> expanded, time, length, peak_rss;
+        auto log_ratio = [](double now, double before, double floor) { return std::log((now + floor) / (before + floor)); };
+
+        for (const auto &entry : current) {
+            if (entry.set != set)
+                continue;
+
+            auto it = baseline_by_deal.find({set, entry.record.deal});
+            if (it == baseline_by_deal.end()) {
+                ++nb_unmatched;
+                continue;
+            }
+
+            const auto &now = entry.record;
+            const auto &before = *it->second;
+            ++nb_matched;
+            solved_before += before.solved;
+            solved_now += now.solved;
+            nb_lost += before.solved && !now.solved;
+            nb_gained += !before.solved && now.solved;
+            if (!now.solved || !before.solved)
+                continue;
+
+            expanded.push_back(log_ratio(now.expanded, before.expanded, count_floor));
+            time.push_back(log_ratio(now.time.count(), before.time.count(), time_floor_us));
+            length.push_back(log_ratio(now.solution_length, before.solution_length, count_floor));
+            peak_rss.push_back(log_ratio(now.peak_rss, before.peak_rss, rss_floor_bytes));
+        }
+
+        // a lost deal is a regression, whatever other deals were gained
+        const char *solved_verdict = nb_lost > 0 ? "REGRESSION" :
+            nb_gained > 0 ? "improvement" : "ok";
+        nb_regressions += nb_lost > 0;
+        os << set << "\tsolved\t" << solved_before << " -> " << solved_now << " of " << nb_matched <<
+            " deals (" << nb_lost << " lost, " << nb_gained << " gained)\t" << solved_verdict << "\n";
+
+        for (const auto &[metric, log_ratios] : {
+                std::make_pair("expanded", &expanded),
+                std::make_pair("time", &time),
+                std::make_pair("length", &length),
+                std::make_pair("peak_rss", &peak_rss)}) {
+            auto change = pairedChange(*log_ratios);
+            auto metric_verdict = verdict(change);
+            nb_regressions += metric_verdict == std::string("REGRESSION");
+            os << set << "\t" << metric << "\tx" << change.ratio << " (t = " << change.t << ", " <<
+                change.nb_deals << " deals solved by both)\t" << metric_verdict << "\n";
+        }
+
+        if (nb_unmatched > 0)
+            os << set << "\t" << nb_unmatched << " deals missing from the baseline\n";
+    }
+
+    return nb_regressions;
+}
@@ -0,0 +1,43 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include "evaluation-type.h"
+#include "game.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A named group of deals of one kind, e.g. easy deals of difficulty 20.
+// Each set of a run draws its deals from its own producer, seeded alike,
+// so the deals do not depend on the other sets of the corpus.
+struct CorpusSet {
+    std::string name;
+    // -1 for random deals
+    int difficulty;
+
+    // "easy-<difficulty>", or "random" for a negative difficulty
+    static CorpusSet forDifficulty(int difficulty) ;
+
+    std::unique_ptr<InitialStateProducerItf> producer(int seed) const;
+};
+
+// throws std::invalid_argument for an unknown corpus name
+std::vector<CorpusSet> corpusSets(const std::string &corpus_name) ;
+
+struct CorpusRecord {
+    std::string set;
+    DealRecord record;
+};
+
+// tab-separated, one line per deal after a header
+void writeCorpusResults(std::ostream &os, const std::vector<CorpusRecord> &records) ;
+// throws std::runtime_error on a malformed file
+std::vector<CorpusRecord> readCorpusResults(std::istream &is) ;
+
+// Compares a run to a baseline deal by deal and prints one verdict per set
+// and metric. Returns the number of significant regressions.
+int compareToBaseline(std::ostream &os, const std::vector<CorpusRecord> &baseline, const std::vector<CorpusRecord> &current) ;
+
+#endif
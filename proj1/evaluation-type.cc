@@ -1,20 +1,134 @@
 #include "evaluation-type.h"
 
+#include <algorithm>
+#include <array>
+
+const char *terminationName(Termination termination) {
+    switch (termination) {
+        case Termination::Solved:
+            return "solved";
+        case Termination::Exhausted:
+            return "exhausted";
+        case Termination::MemLimit:
+            return "mem-limit";
+        case Termination::Timeout:
+            return "timeout";
+        case Termination::NodeLimit:
+            return "node-limit";
+    }
+    return "unknown";
+}
+
+StrategyEvaluation &StrategyEvaluation::operator+=(const StrategyEvaluation &other) {
+    search += other.search;
+    tt_hits += other.tt_hits;
+    tt_misses += other.tt_misses;
+    tt_evictions += other.tt_evictions;
+
+    if (workers.size() < other.workers.size())
+        workers.resize(other.workers.size());
+    for (std::size_t i = 0; i < other.workers.size(); ++i) {
+        workers[i].expanded += other.workers[i].expanded;
+        workers[i].time_taken += other.workers[i].time_taken;
+    }
+
+    peak_layer_size = std::max(peak_layer_size, other.peak_layer_size);
+
+    // workers of fc-sui --jobs interleave the deals
+    auto nb_own = improvements.size();
+    improvements.insert(improvements.end(), other.improvements.begin(), other.improvements.end());
+    std::inplace_merge(improvements.begin(), improvements.begin() + nb_own, improvements.end(),
+        [](const SolutionImprovement &a, const SolutionImprovement &b) {
+            return a.deal < b.deal || (a.deal == b.deal && a.time < b.time);
+        });
+
+    auto nb_own_deals = deals.size();
+    deals.insert(deals.end(), other.deals.begin(), other.deals.end());
+    std::inplace_merge(deals.begin(), deals.begin() + nb_own_deals, deals.end(),
+        [](const DealRecord &a, const DealRecord &b) { return a.deal < b.deal; });
+    return *this;
+}
+
+// nearest-rank percentile of sorted values
+static std::chrono::microseconds percentile(const std::vector<std::chrono::microseconds> &sorted, int p) {
+    auto rank = (p * sorted.size() + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
 std::ostream& operator<< (std::ostream& os, const StrategyEvaluation &report) {
-    if (report.nb_solved > 0) {
-        os << "Solved " << report.nb_solved << " / " << report.nb_solved + report.nb_failed <<
-            " [ " << 100.0*report.nb_solved / (report.nb_solved + report.nb_failed) << " % ]. " <<
-            "Avg solution length " << 1.0 * report.total_solution_length / report.nb_solved << " steps, "
-            "Avg time taken: " << (report.time_taken / report.nb_solved).count() << " us " <<
-            "Total #states expaned: " << report.nb_states_expanded << 
-            "\n";
+    unsigned long nb_solved = 0;
+    unsigned long total_solution_length = 0;
+    std::chrono::microseconds time_taken{0};
+    std::vector<std::chrono::microseconds> deal_times;
+    std::array<unsigned long, 5> nb_by_termination{};
+    for (const auto &deal : report.deals) {
+        if (deal.solved) {
+            ++nb_solved;
+            total_solution_length += deal.solution_length;
+            time_taken += deal.time;
+        }
+        deal_times.push_back(deal.time);
+        ++nb_by_termination[static_cast<int>(deal.termination)];
+    }
+    auto nb_deals = report.deals.size();
+
+    if (nb_solved > 0) {
+        os << "Solved " << nb_solved << " / " << nb_deals <<
+            " [ " << 100.0*nb_solved / nb_deals << " % ]. " <<
+            "Avg solution length " << 1.0 * total_solution_length / nb_solved << " steps, "
+            "Avg time taken: " << (time_taken / nb_solved).count() << " us " <<
+            "Total #states expaned: " << report.search.expanded;
     } else {
-        os << "Solved " << report.nb_solved << " / " << report.nb_solved + report.nb_failed <<
+        os << "Solved " << nb_solved << " / " << nb_deals <<
             " [ 0 % ]. " <<
             "Avg solution length NA steps, " <<
             "Avg time taken: NA us " <<
-            "Total #states expaned: " << report.nb_states_expanded << 
-            "\n";
+            "Total #states expaned: " << report.search.expanded;
+    }
+
+    os << " generated: " << report.search.generated <<
+        ", duplicates: " << report.search.duplicates <<
+        ", auto-moves: " << report.search.auto_moves;
+    if (report.search.heuristic_calls > 0)
+        os << ", heuristic calls: " << report.search.heuristic_calls;
+
+    if (report.tt_hits + report.tt_misses > 0) {
+        os << " TT hits: " << report.tt_hits <<
+            ", misses: " << report.tt_misses <<
+            ", evictions: " << report.tt_evictions;
+    }
+
+    // tail latency over all deals, solved or not
+    if (!deal_times.empty()) {
+        std::sort(deal_times.begin(), deal_times.end());
+        os << " Time p50/p90/p99: " << percentile(deal_times, 50).count() <<
+            " / " << percentile(deal_times, 90).count() <<
+            " / " << percentile(deal_times, 99).count() << " us";
+    }
+
+    if (nb_solved < nb_deals) {
+        os << " Unsolved:";
+        for (auto termination : {Termination::Exhausted, Termination::MemLimit, Termination::Timeout, Termination::NodeLimit}) {
+            if (nb_by_termination[static_cast<int>(termination)] > 0)
+                os << " " << terminationName(termination) << " " << nb_by_termination[static_cast<int>(termination)];
+        }
+    }
+
+    if (report.peak_layer_size > 0)
+        os << " Peak beam layer: " << report.peak_layer_size;
+
+    if (!report.workers.empty()) {
+        os << " Expansions per second by worker:";
+        for (const auto &worker : report.workers) {
+            auto seconds = std::chrono::duration<double>(worker.time_taken).count();
+            os << " " << (seconds > 0 ? worker.expanded / seconds : 0.0);
+        }
+    }
+    os << "\n";
+
+    for (const auto &improvement : report.improvements) {
+        os << "Deal " << improvement.deal << ": solution of " << improvement.length <<
+            " steps after " << improvement.time.count() << " us\n";
     }
 
     return os;
@@ -1,16 +1,72 @@
 #ifndef EVALUATION_TYPE_H
 #define EVALUATION_TYPE_H
 
+#include "search-counters.h"
+
 #include <chrono>
 #include <iostream>
+#include <vector>
+
+// a better solution found by an anytime strategy
+struct SolutionImprovement {
+    unsigned long deal;
+    std::size_t length;
+    // since the start of the solve
+    std::chrono::microseconds time;
+};
+
+// why a solve() ended
+enum class Termination {Solved, Exhausted, MemLimit, Timeout, NodeLimit};
+
+// "solved", "exhausted", "mem-limit", "timeout" or "node-limit"
+const char *terminationName(Termination termination) ;
+
+// outcome of a single deal
+struct DealRecord {
+    unsigned long deal = 0;
+    bool solved = false;
+    Termination termination = Termination::Exhausted;
+    std::size_t solution_length = 0;
+    unsigned long long expanded = 0;
+    unsigned long long generated = 0;
+    std::chrono::microseconds time{0};
+    // peak resident set size of the whole process, in bytes, from the start
+    // of the solve to its end; with fc-sui --jobs the peak is not restarted
+    // for each deal and stays the peak of the run so far
+    std::size_t peak_rss = 0;
+};
+
+// work of one thread of a parallel strategy
+struct WorkerStatistics {
+    unsigned long long expanded = 0;
+    std::chrono::microseconds time_taken{0};
+};
 
 struct StrategyEvaluation {
-	StrategyEvaluation() : nb_solved(0), nb_failed(0), total_solution_length(0), nb_states_expanded(0), time_taken(0) {}
-    unsigned long nb_solved;
-    unsigned long nb_failed;
-    unsigned long total_solution_length;
-    unsigned long long nb_states_expanded;
-    std::chrono::microseconds time_taken;
+	StrategyEvaluation() : tt_hits(0), tt_misses(0), tt_evictions(0) {}
+
+    // one per deal, ordered by deal; the summary is computed from these
+    std::vector<DealRecord> deals;
+
+    // search counters, summed over all solved and failed deals
+    SearchCounters search;
+
+    // transposition table counters, summed over all solved and failed deals
+    unsigned long long tt_hits;
+    unsigned long long tt_misses;
+    unsigned long long tt_evictions;
+
+    // per worker thread, filled by parallel strategies only
+    std::vector<WorkerStatistics> workers;
+
+    // largest layer kept by the beam search
+    std::size_t peak_layer_size = 0;
+
+    // ordered by deal, then by time
+    std::vector<SolutionImprovement> improvements;
+
+    // merges the record of another worker, counters are summed
+    StrategyEvaluation &operator+=(const StrategyEvaluation &other);
 };
 
 std::ostream& operator<< (std::ostream& os, const StrategyEvaluation &report) ;
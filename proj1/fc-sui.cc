@@ -5,22 +5,30 @@
 
 #include "evaluation-type.h"
 #include "argparse.h"
+#include "corpus.h"
 #include "mem_watch.h"
+#include "memusage.h"
+#include "results-sink.h"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <sstream>
+#include <string>
 
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <vector>
 
 
 
 
 
 #include <malloc.h>
-#include <chrono>
 
 
 
@@ -28,50 +36,96 @@
 void eval_strategy(
         std::unique_ptr<SearchStrategyItf> &search_strategy,
         const SearchState &init_state,
-        StrategyEvaluation *report
+        StrategyEvaluation *report,
+        unsigned long deal,
+        std::chrono::milliseconds cool_down,
+        bool per_deal_rss
     ) {
     malloc_trim(0);
-     // Get the current time
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    // Wait for 1 second
-    while (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::high_resolution_clock::now() - start_time).count() < 1);
 
-    
+    // let the machine settle between deals, e.g. for timing experiments
+    if (cool_down.count() > 0)
+        std::this_thread::sleep_for(cool_down);
 
+    if (per_deal_rss)
+        resetPeakRSS();
+    threadCounters() = {};
     auto t0 = std::chrono::steady_clock::now();
 	auto solution = search_strategy->solve(init_state);
     auto t1 = std::chrono::steady_clock::now();
+    report->search += threadCounters();
+    auto nb_improvements = report->improvements.size();
 
+    DealRecord record;
+    record.deal = deal;
+    record.expanded = threadCounters().expanded;
+    record.generated = threadCounters().generated;
+    record.time = std::chrono::duration_cast<decltype(record.time)>(t1 - t0);
+    record.peak_rss = getPeakRSSSinceReset();
 
 	SearchState in_progress(init_state);
 	for (const auto & action : solution)
 		in_progress = action.execute(in_progress);
 
     if (in_progress.isFinal()) {
-        report->nb_solved++;
-        report->total_solution_length += solution.size();
-        report->time_taken += std::chrono::duration_cast<decltype(report->time_taken)>(t1 - t0);
+        record.solved = true;
+        record.termination = Termination::Solved;
+        record.solution_length = solution.size();
     } else {
-        report->nb_failed++;
+        record.termination = search_strategy->termination();
     }
-    report->nb_states_expanded = SearchState::nbExpanded();
+    search_strategy->reportStatistics(report);
+    for (auto i = nb_improvements; i < report->improvements.size(); ++i)
+        report->improvements[i].deal = deal;
+    report->deals.push_back(record);
 }
 
-std::unique_ptr<InitialStateProducerItf> getProducer(const argparse::ArgumentParser &parser) {
-    auto difficulty = parser.get<int>("--easy-mode");
-    auto seed = parser.get<int>("seed");
+// Hands out the deals in the order of the producer, whichever worker asks
+class DealQueue {
+public:
+    DealQueue(std::unique_ptr<InitialStateProducerItf> &&producer, int nb_games) :
+        producer_(std::move(producer)), nb_left_(nb_games) {}
+
+    // also gives the position of the deal in the run
+    bool next(GameState *deal, unsigned long *deal_idx) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (nb_left_ <= 0)
+            return false;
+
+        --nb_left_;
+        *deal = producer_->produce();
+        *deal_idx = nb_produced_++;
+        return true;
+    }
 
-    if (difficulty < 0) {
-        return std::make_unique<RandomProducer>(seed);
-    } else {
-        return std::make_unique<EasyProducer>(seed, difficulty);
+private:
+    std::mutex mutex_;
+    std::unique_ptr<InitialStateProducerItf> producer_;
+    int nb_left_;
+    unsigned long nb_produced_ = 0;
+};
+
+void eval_worker(
+        DealQueue *deals,
+        std::unique_ptr<SearchStrategyItf> search_strategy,
+        SearchOptions search_options,
+        std::chrono::milliseconds cool_down,
+        bool per_deal_rss,
+        StrategyEvaluation *report
+    ) {
+    GameState gs;
+    unsigned long deal_idx;
+    while (deals->next(&gs, &deal_idx)) {
+        SearchState init_state(gs, search_options);
+        eval_strategy(search_strategy, init_state, report, deal_idx, cool_down, per_deal_rss);
     }
 }
 
-std::unique_ptr<AStarHeuristicItf> getHeuristic(const argparse::ArgumentParser &parser) {
-    auto heuristic_name = parser.get<std::string>("--heuristic");
+CorpusSet getDealSet(const argparse::ArgumentParser &parser) {
+    return CorpusSet::forDifficulty(parser.get<int>("--easy-mode"));
+}
 
+std::unique_ptr<AStarHeuristicItf> getHeuristic(const std::string &heuristic_name) {
     if (heuristic_name == "nb_not_home") {
         return std::make_unique<OufOfHome_Pseudo>();
     } else if (heuristic_name == "student") {
@@ -83,24 +137,224 @@ std::unique_ptr<AStarHeuristicItf> getHeuristic(const argparse::ArgumentParser &
     }
 }
 
-std::unique_ptr<SearchStrategyItf> getSolver(const argparse::ArgumentParser &parser) {
-    auto solver_name = parser.get<std::string>("--solver");
+ReplacementPolicy getReplacementPolicy(const argparse::ArgumentParser &parser) {
+    try {
+        return replacementPolicyFromName(parser.get<std::string>("--tt-policy"));
+    } catch (const std::invalid_argument &err) {
+        std::cerr << err.what() << "\n";
+        std::exit(2);
+    }
+}
+
+std::unique_ptr<SearchStrategyItf> getSolver(
+        const argparse::ArgumentParser &parser,
+        const std::string &solver_name,
+        const std::string &heuristic_name,
+        size_t mem_limit,
+        size_t nb_sharing = 1
+    ) {
+    // solvers running side by side split the memory of their tables
+    TableConfig table{mem_limit / tt_memory_divisor / nb_sharing, getReplacementPolicy(parser)};
+    // 0 leaves the choice to the solver
+    auto weight = parser.get<double>("--weight");
+    if (weight != 0.0 && !(weight >= 1.0)) {
+        std::cerr << "--weight has to be at least 1\n";
+        std::exit(2);
+    }
 
     if (solver_name == "dummy") {
         return std::make_unique<DummySearch>(500, 5);
     } else if (solver_name == "bfs") {
-	    return std::make_unique<BreadthFirstSearch>(parser.get<size_t>("--mem-limit"));
+	    return std::make_unique<BreadthFirstSearch>(mem_limit, table);
     } else if (solver_name == "dfs") {
-        return std::make_unique<DepthFirstSearch>(parser.get<int>("--dls-limit"), parser.get<size_t>("--mem-limit"));
+        return std::make_unique<DepthFirstSearch>(parser.get<int>("--dls-limit"), mem_limit, table);
     } else if (solver_name == "a_star") {
-        return std::make_unique<AStarSearch>(getHeuristic(parser), parser.get<size_t>("--mem-limit"));
+        return std::make_unique<AStarSearch>(getHeuristic(heuristic_name), mem_limit, table, weight > 0 ? weight : 1.0);
+    } else if (solver_name == "ara_star") {
+        // the weight has to go down after every solution
+        auto weight_step = parser.get<double>("--weight-step");
+        if (!(weight_step > 0.0)) {
+            std::cerr << "--weight-step has to be positive\n";
+            std::exit(2);
+        }
+        return std::make_unique<AnytimeAStar>(
+            getHeuristic(heuristic_name), mem_limit, table,
+            weight > 0 ? weight : 3.0,
+            weight_step,
+            std::chrono::milliseconds(parser.get<int>("--deadline"))
+        );
+    } else if (solver_name == "beam") {
+        auto beam_width = parser.get<int>("--beam-width");
+        auto beam_depth = parser.get<int>("--beam-depth");
+        if (beam_width < 1 || beam_depth < 1) {
+            std::cerr << "--beam-width and --beam-depth have to be at least 1\n";
+            std::exit(2);
+        }
+        return std::make_unique<BeamSearch>(getHeuristic(heuristic_name), beam_width, beam_depth);
+    } else if (solver_name == "hda_star") {
+        auto nb_threads = parser.get<int>("--threads");
+        if (nb_threads < 1)
+            nb_threads = std::max(1u, std::thread::hardware_concurrency());
+        return std::make_unique<HashDistributedAStar>(getHeuristic(heuristic_name), mem_limit, table, nb_threads);
+    } else if (solver_name == "ida_star") {
+        return std::make_unique<IterativeDeepeningAStar>(getHeuristic(heuristic_name));
     } else {
         std::cerr << "Unknown solver name '" << solver_name << "'\n";
-        std::cerr << "Supported are: dummy, bfs, a_star, dfs\n";
+        std::cerr << "Supported are: dummy, bfs, a_star, ara_star, beam, hda_star, ida_star, dfs, portfolio\n";
+        std::exit(2);
+    }
+}
+
+// --portfolio lists solver[/heuristic] members separated by commas.
+// Every member gets the whole --mem-limit: their budgets are anchored to the
+// resident memory of the process, so each one sees what the others use.
+std::unique_ptr<SearchStrategyItf> getPortfolio(const argparse::ArgumentParser &parser) {
+    std::vector<std::pair<std::string, std::string>> members;
+    std::stringstream spec(parser.get<std::string>("--portfolio"));
+    for (std::string member; std::getline(spec, member, ',');) {
+        auto slash = member.find('/');
+        if (slash == std::string::npos)
+            members.emplace_back(member, parser.get<std::string>("--heuristic"));
+        else
+            members.emplace_back(member.substr(0, slash), member.substr(slash + 1));
+    }
+
+    if (members.empty()) {
+        std::cerr << "--portfolio needs at least one solver\n";
+        std::exit(2);
+    }
+
+    auto mem_limit = parser.get<size_t>("--mem-limit");
+    std::vector<std::unique_ptr<SearchStrategyItf>> strategies;
+    for (const auto &[solver_name, heuristic_name] : members) {
+        if (solver_name == "portfolio") {
+            std::cerr << "A portfolio can not contain another one\n";
+            std::exit(2);
+        }
+        strategies.push_back(getSolver(parser, solver_name, heuristic_name, mem_limit, members.size()));
+    }
+
+    auto pick_name = parser.get<std::string>("--portfolio-pick");
+    PortfolioSearch::Pick pick;
+    if (pick_name == "first") {
+        pick = PortfolioSearch::Pick::First;
+    } else if (pick_name == "shortest") {
+        pick = PortfolioSearch::Pick::Shortest;
+    } else {
+        std::cerr << "Unknown portfolio pick '" << pick_name << "'\n";
+        std::cerr << "Supported are: first, shortest\n";
+        std::exit(2);
+    }
+
+    std::chrono::milliseconds deadline(parser.get<int>("--deadline"));
+    return std::make_unique<PortfolioSearch>(std::move(strategies), pick, deadline);
+}
+
+// --time-limit and --node-limit cap every deal, 0 for none
+SearchLimits getLimits(const argparse::ArgumentParser &parser) {
+    auto time_limit = parser.get<int>("--time-limit");
+    if (time_limit < 0) {
+        std::cerr << "--time-limit can not be negative\n";
         std::exit(2);
     }
+    return {std::chrono::milliseconds(time_limit), parser.get<size_t>("--node-limit")};
 }
 
+std::unique_ptr<SearchStrategyItf> getSolver(const argparse::ArgumentParser &parser) {
+    auto solver_name = parser.get<std::string>("--solver");
+    auto solver = solver_name == "portfolio" ?
+        getPortfolio(parser) :
+        getSolver(parser, solver_name, parser.get<std::string>("--heuristic"), parser.get<size_t>("--mem-limit"));
+
+    solver->setLimits(getLimits(parser));
+    return solver;
+}
+
+void run_deals(const argparse::ArgumentParser &parser, DealQueue *deals, StrategyEvaluation *evaluation_record) {
+    auto nb_jobs = parser.get<int>("--jobs");
+
+    SearchOptions search_options;
+    search_options.canonical = parser.get<bool>("--canonical");
+    search_options.supermoves = parser.get<bool>("--supermoves");
+    std::chrono::milliseconds cool_down(parser.get<int>("--cool-down"));
+
+    if (nb_jobs == 1) {
+        eval_worker(deals, getSolver(parser), search_options, cool_down, true, evaluation_record);
+    } else {
+        // every worker owns its strategy and record, the records are merged at the end;
+        // the peak RSS is a process-wide figure, so it cannot be restarted for each deal
+        std::vector<StrategyEvaluation> worker_records(nb_jobs);
+        std::vector<std::thread> workers;
+        for (int i = 0; i < nb_jobs; ++i)
+            workers.emplace_back(eval_worker, deals, getSolver(parser), search_options, cool_down, false, &worker_records[i]);
+
+        for (auto &worker : workers)
+            worker.join();
+        for (const auto &record : worker_records)
+            *evaluation_record += record;
+    }
+}
+
+// Runs every set of the corpus, nb_games deals each, and optionally saves
+// the per-deal results and compares them to a baseline.
+// The sink, if any, gets the results of every set.
+// Returns the exit code, 1 if the comparison found a regression.
+int run_corpus(const argparse::ArgumentParser &parser, const std::string &corpus_name, ResultsSink *sink, StrategyEvaluation *evaluation_record) {
+    std::vector<CorpusSet> sets;
+    try {
+        sets = corpusSets(corpus_name);
+    } catch (const std::invalid_argument &err) {
+        std::cerr << err.what() << "\n";
+        std::exit(2);
+    }
+
+    std::vector<CorpusRecord> baseline;
+    auto baseline_path = parser.get<std::string>("--baseline");
+    if (!baseline_path.empty()) {
+        std::ifstream baseline_file(baseline_path);
+        if (!baseline_file) {
+            std::cerr << "Cannot open baseline '" << baseline_path << "'\n";
+            std::exit(2);
+        }
+        try {
+            baseline = readCorpusResults(baseline_file);
+        } catch (const std::runtime_error &err) {
+            std::cerr << baseline_path << ": " << err.what() << "\n";
+            std::exit(2);
+        }
+    }
+
+    std::vector<CorpusRecord> results;
+    for (const auto &set : sets) {
+        DealQueue deals(set.producer(parser.get<int>("seed")), parser.get<int>("nb_games"));
+        StrategyEvaluation set_record;
+        run_deals(parser, &deals, &set_record);
+        std::cout << set.name << ": " << set_record;
+
+        for (const auto &record : set_record.deals)
+            results.push_back({set.name, record});
+        if (sink)
+            sink->write(set.name, set_record.deals);
+        *evaluation_record += set_record;
+    }
+
+    auto results_path = parser.get<std::string>("--corpus-out");
+    if (!results_path.empty()) {
+        std::ofstream results_file(results_path);
+        writeCorpusResults(results_file, results);
+        if (!results_file) {
+            std::cerr << "Cannot write corpus results to '" << results_path << "'\n";
+            std::exit(2);
+        }
+    }
+
+    if (baseline_path.empty())
+        return 0;
+
+    std::cout << "Compared to " << baseline_path << ":\n";
+    auto nb_regressions = compareToBaseline(std::cout, baseline, results);
+    return nb_regressions > 0 ? 1 : 0;
+}
 
 int main(int argc, const char *argv[]) {
     argparse::ArgumentParser parser("FreeCell@SUI");
@@ -112,6 +366,26 @@ int main(int argc, const char *argv[]) {
     parser.add_argument("--heuristic").default_value(std::string("nb_not_home"));
     parser.add_argument("--dls-limit").default_value(1'000'000).scan<'d', int>();
     parser.add_argument("--mem-limit").default_value(std::size_t{2'147'483'648}).scan<'u', size_t>();
+    parser.add_argument("--canonical").default_value(false).implicit_value(true);
+    parser.add_argument("--supermoves").default_value(false).implicit_value(true);
+    parser.add_argument("--tt-policy").default_value(std::string("two_tier"));
+    parser.add_argument("--weight").default_value(0.0).scan<'g', double>();
+    parser.add_argument("--weight-step").default_value(0.5).scan<'g', double>();
+    parser.add_argument("--beam-width").default_value(1000).scan<'d', int>();
+    parser.add_argument("--beam-depth").default_value(500).scan<'d', int>();
+    parser.add_argument("--threads").default_value(0).scan<'d', int>();
+    parser.add_argument("--portfolio").default_value(std::string("a_star/nb_not_home,a_star/student,dummy"));
+    parser.add_argument("--portfolio-pick").default_value(std::string("first"));
+    parser.add_argument("--deadline").default_value(0).scan<'d', int>();
+    parser.add_argument("--time-limit").default_value(0).scan<'d', int>();
+    parser.add_argument("--node-limit").default_value(std::size_t{0}).scan<'u', size_t>();
+    parser.add_argument("--jobs").default_value(1).scan<'d', int>();
+    parser.add_argument("--cool-down").default_value(0).scan<'d', int>();
+    parser.add_argument("--results").default_value(std::string(""));
+    parser.add_argument("--results-format").default_value(std::string("jsonl"));
+    parser.add_argument("--corpus").default_value(std::string(""));
+    parser.add_argument("--corpus-out").default_value(std::string(""));
+    parser.add_argument("--baseline").default_value(std::string(""));
 
     try {
         parser.parse_args(argc, argv);
@@ -121,6 +395,33 @@ int main(int argc, const char *argv[]) {
         std::exit(2);
     }
 
+    auto nb_jobs = parser.get<int>("--jobs");
+    if (nb_jobs < 1) {
+        std::cerr << "--jobs has to be at least 1\n";
+        std::exit(2);
+    }
+
+    std::ofstream results_file;
+    std::unique_ptr<ResultsSink> sink;
+    auto results_path = parser.get<std::string>("--results");
+    if (!results_path.empty()) {
+        ResultsSink::Format format;
+        try {
+            format = ResultsSink::formatFromName(parser.get<std::string>("--results-format"));
+        } catch (const std::invalid_argument &err) {
+            std::cerr << err.what() << "\n";
+            std::exit(2);
+        }
+
+        results_file.open(results_path);
+        if (!results_file) {
+            std::cerr << "Cannot open results file '" << results_path << "'\n";
+            std::exit(2);
+        }
+        RunDescription run{parser.get<int>("seed"), parser.get<std::string>("--solver"), parser.get<std::string>("--heuristic")};
+        sink = std::make_unique<ResultsSink>(results_file, format, run);
+    }
+
     StrategyEvaluation evaluation_record;
 
     MemWatcher mem_watcher(
@@ -130,18 +431,25 @@ int main(int argc, const char *argv[]) {
     );
     std::thread thread_mem_watch(&MemWatcher::run, &mem_watcher);
 
-    std::unique_ptr<InitialStateProducerItf> producer = getProducer(parser);
-    std::unique_ptr<SearchStrategyItf> search_strategy = getSolver(parser);
+    auto corpus_name = parser.get<std::string>("--corpus");
+    int exit_code = 0;
+    if (corpus_name.empty()) {
+        auto set = getDealSet(parser);
+        DealQueue deals(set.producer(parser.get<int>("seed")), parser.get<int>("nb_games"));
+        run_deals(parser, &deals, &evaluation_record);
+        if (sink)
+            sink->write(set.name, evaluation_record.deals);
 
-    auto nb_games = parser.get<int>("nb_games");
-    for (int i = 0; i < nb_games; ++i) {
-        GameState gs = producer->produce();
-        SearchState init_state(gs);
-        eval_strategy(search_strategy, init_state, &evaluation_record);
-    }
+        mem_watcher.kill();
+        thread_mem_watch.join();
+
+        std::cout << evaluation_record;
+    } else {
+        exit_code = run_corpus(parser, corpus_name, sink.get(), &evaluation_record);
 
-    mem_watcher.kill();
-    thread_mem_watch.join();
+        mem_watcher.kill();
+        thread_mem_watch.join();
+    }
 
-    std::cout << evaluation_record;
+    return exit_code;
 }
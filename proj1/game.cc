@@ -8,8 +8,8 @@
 #include <tuple>
 
 template <typename In>
-std::vector<CardStorage *> collect_location_pointers(In begin, In end) {
-    std::vector<CardStorage *> adresses;
+auto collect_location_pointers(In begin, In end) {
+    std::vector<std::remove_reference_t<decltype(*begin)> *> adresses;
     for (auto it=begin; it != end; ++it)
         adresses.push_back(it);
 
@@ -83,22 +83,23 @@ std::vector<Card> topCards(const GameState &gs) {
 int moveCardsFromHomes(GameState *gs, int max_nb_cards, size_t stack_begin, size_t stack_end, std::default_random_engine rng) {
     int nb_cards_moved = 0;
     for (; nb_cards_moved < max_nb_cards; ++nb_cards_moved) {
-        std::vector<CardStorage *> considered_froms{&gs->homes[nb_cards_moved % gs->homes.size()]};
-        std::vector<CardStorage *> considered_tos = collect_location_pointers(gs->stacks.begin() + stack_begin, gs->stacks.begin() + stack_end);
-
-        auto moves = availableMoves(
-            considered_froms.begin(),
-            considered_froms.end(),
-            considered_tos.begin(),
-            considered_tos.end()
-        );
+        std::vector<HomeDestination *> considered_froms{&gs->homes[nb_cards_moved % gs->homes.size()]};
+        std::vector<WorkStack *> considered_tos = collect_location_pointers(gs->stacks.begin() + stack_begin, gs->stacks.begin() + stack_end);
+
+        // as availableMoves() does, but keeping the concrete types for a statically dispatched move
+        std::vector<std::pair<HomeDestination *, WorkStack *>> moves;
+        for (auto from : considered_froms) {
+            for (auto to : considered_tos) {
+                if (moveLegal(from, to))
+                    moves.push_back({from, to});
+            }
+        }
 
         if (moves.size() == 0)
             break;
 
         int pick = std::uniform_int_distribution<std::mt19937::result_type>(0, moves.size()-1)(rng);
-        // we have a non-const access to GameState (gs), so we are allowed to de-const the pointers in RawMove
-        move(const_cast<CardStorage *>(moves[pick].first), const_cast<CardStorage *>(moves[pick].second));
+        move(moves[pick].first, moves[pick].second);
     }
 
     return nb_cards_moved;
@@ -233,7 +234,7 @@ auto findHomeFor(const GameState &gs, Card card) -> decltype(gs.homes)::const_it
     return std::find_if(
         gs.homes.begin(),
         gs.homes.end(),
-        [&](const CardStorage &cs){return cs.canAccept(card);}
+        [&](const HomeDestination &home){return home.canAccept(card);}
     );
 }
 
@@ -257,12 +258,12 @@ bool cardCouldGoHome(const GameState &gs, Card card) {
     if (card.value == 1 or card.value == 2)
         return true;
 
-    auto render_color{render_color_map.at(card.color)}; 
+    auto render_color{renderColor(card.color)};
     std::vector<Color> opposite_rc_colors;
     bool safe = true;
 
     for (auto & color : colors_list) {
-        if (render_color_map.at(color) == render_color)
+        if (renderColor(color) == render_color)
             continue;
 
         if (!cardIsHome(gs, {color, card.value-1}))
@@ -275,16 +276,21 @@ bool cardCouldGoHome(const GameState &gs, Card card) {
 std::vector<RawMove> safeHomeMoves(const GameState &gs) {
     std::vector<RawMove> moves;
 
-    for (auto &cs : gs.non_homes) {
-        auto opt_card = cs->topCard();
-
-        if (!opt_card.has_value())
-            continue;
-
-        auto home_it = findHomeFor(gs, *opt_card);
-        if (home_it != gs.homes.end() && cardCouldGoHome(gs, *opt_card))
-            moves.push_back({cs, home_it});
-    }
+    // free cells first, then stacks, the order of gs.non_homes
+    auto collect = [&](const auto &storages) {
+        for (auto &cs : storages) {
+            auto opt_card = cs.topCard();
+
+            if (!opt_card.has_value())
+                continue;
+
+            auto home_it = findHomeFor(gs, *opt_card);
+            if (home_it != gs.homes.end() && cardCouldGoHome(gs, *opt_card))
+                moves.push_back({&cs, home_it});
+        }
+    };
+    collect(gs.free_cells);
+    collect(gs.stacks);
 
     return moves;
 }
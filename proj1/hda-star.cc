@@ -0,0 +1,280 @@
+#include "search-strategies.h"
+#include "mpsc-queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <queue>
+#include <thread>
+
+// A node of some worker, its parent may belong to another one
+struct HdaNode {
+    SearchState state;
+    std::uint32_t parent_owner;
+    NodeIndex parent;
+    std::uint32_t depth;
+    PackedMove action;
+};
+
+struct HdaOpen {
+    double f;
+    double h;
+    NodeIndex node;
+};
+
+// lower f first, then lower h
+struct HdaOpenCompare {
+    bool operator()(const HdaOpen &lhs, const HdaOpen &rhs) const {
+        return lhs.f > rhs.f || (lhs.f == rhs.f && lhs.h > rhs.h);
+    }
+};
+
+using HdaBatch = std::vector<HdaNode>;
+
+// children are sent once that many are waiting for the same owner
+static constexpr std::size_t hda_batch_size = 64;
+// and at the latest after that many expansions
+static constexpr unsigned hda_flush_period = 16;
+
+struct HdaWorker {
+    HdaWorker(int id, int nb_workers, size_t mem_limit, const TableConfig &table) :
+        id(id),
+        outboxes(nb_workers),
+        budget(mem_limit),
+        arena(&budget),
+        closed(table)
+        {}
+
+    int id;
+    MpscQueue<HdaBatch> inbox;
+    std::vector<HdaBatch> outboxes;
+    MemoryBudget budget;
+    NodeArena<HdaNode> arena;
+    TranspositionTable closed;
+    std::priority_queue<HdaOpen, std::vector<HdaOpen>, HdaOpenCompare> open;
+    // each worker gets an even share of the node cap
+    LimitCheck limits;
+    // why this worker stopped, Exhausted when another one stopped them all
+    Termination termination = Termination::Exhausted;
+
+    SearchCounters counters;
+    std::chrono::microseconds time_taken{0};
+};
+
+// the low bits of the key index the transposition tables
+static int owner(ZobristKey key, std::size_t nb_workers) {
+    return (key >> 32) % nb_workers;
+}
+
+HashDistributedAStar::HashDistributedAStar(std::unique_ptr<AStarHeuristicItf> &&heuristic, size_t mem_limit, const TableConfig &table, int nb_threads) :
+        heuristic_(std::move(heuristic)),
+        stop_(false),
+        found_(false),
+        outstanding_(0),
+        goal_owner_(0),
+        goal_(no_node) {
+    TableConfig worker_table{table.nb_bytes / nb_threads, table.policy};
+    for (int i = 0; i < nb_threads; ++i)
+        workers_.push_back(std::make_unique<HdaWorker>(i, nb_threads, mem_limit, worker_table));
+}
+
+HashDistributedAStar::~HashDistributedAStar() = default;
+
+std::vector<SearchAction> HashDistributedAStar::solve(const SearchState &init_state) {
+    if (init_state.isFinal())
+        return {};
+
+    for (auto &worker : workers_) {
+        HdaBatch leftover;
+        while (worker->inbox.pop(&leftover))
+            ;
+        for (auto &outbox : worker->outboxes)
+            outbox.clear();
+        worker->budget.reset();
+        worker->arena.clear();
+        worker->closed.clear();
+        worker->open = {};
+        worker->counters = {};
+        worker->time_taken = {};
+        worker->limits.start(limits_, workers_.size());
+        worker->termination = Termination::Exhausted;
+    }
+
+    stop_ = false;
+    found_ = false;
+    outstanding_ = 1;
+    goal_ = no_node;
+
+    auto &root_owner = *workers_[owner(init_state.key(), workers_.size())];
+    auto root = root_owner.arena.push({init_state, 0, no_node, 0, {}});
+    root_owner.open.push({0.0, 0.0, root});
+
+    std::vector<std::thread> threads;
+    for (auto &worker : workers_)
+        threads.emplace_back(&HashDistributedAStar::run_, this, std::ref(*worker));
+    for (auto &thread : threads)
+        thread.join();
+
+    // the workers counted on their own threads
+    for (const auto &worker : workers_)
+        threadCounters() += worker->counters;
+
+    if (goal_ == no_node) {
+        // the first worker to hit a limit stopped the others
+        for (const auto &worker : workers_) {
+            if (worker->termination != Termination::Exhausted)
+                return giveUp_(worker->termination);
+        }
+        return giveUp_(Termination::Exhausted);
+    }
+
+    std::vector<SearchAction> solution;
+    for (std::uint32_t owner_id = goal_owner_, idx = goal_; ; ) {
+        const auto &node = workers_[owner_id]->arena[idx];
+        if (node.parent == no_node)
+            break;
+        solution.emplace_back(node.action);
+        owner_id = node.parent_owner;
+        idx = node.parent;
+    }
+
+    std::reverse(solution.begin(), solution.end());
+    return solution;
+}
+
+void HashDistributedAStar::receive_(HdaWorker &worker, const HdaNode &node) {
+    if (worker.closed.contains(node.state.key(), node.depth)) {
+        ++threadCounters().duplicates;
+        --outstanding_;
+        return;
+    }
+
+    auto idx = worker.arena.push(node);
+    auto h = compute_heuristic(node.state, *heuristic_);
+    worker.open.push({h + node.depth, h, idx});
+    worker.budget.charge(sizeof(HdaOpen));
+}
+
+void HashDistributedAStar::flush_(HdaWorker &worker, int owner_id) {
+    auto &outbox = worker.outboxes[owner_id];
+    if (outbox.empty())
+        return;
+
+    HdaBatch batch;
+    batch.reserve(hda_batch_size);
+    std::swap(batch, outbox);
+    workers_[owner_id]->inbox.push(std::move(batch));
+}
+
+void HashDistributedAStar::run_(HdaWorker &worker) {
+    auto t0 = std::chrono::steady_clock::now();
+    threadCounters() = {};
+    unsigned nb_since_flush = 0;
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        if (stop_token_.stopRequested()) {
+            worker.termination = Termination::Timeout;
+            break;
+        }
+
+        HdaBatch batch;
+        while (worker.inbox.pop(&batch))
+            for (const auto &node : batch)
+                receive_(worker, node);
+
+        if (worker.open.empty()) {
+            for (int i = 0; i < static_cast<int>(workers_.size()); ++i)
+                flush_(worker, i);
+            nb_since_flush = 0;
+
+            if (outstanding_ == 0) {
+                stop_ = true;
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+
+        auto current = worker.open.top().node;
+        worker.open.pop();
+        worker.budget.release(sizeof(HdaOpen));
+
+        const auto &node = worker.arena[current];
+        if (worker.closed.contains(node.state.key(), node.depth)) {
+            ++threadCounters().duplicates;
+            --outstanding_;
+            continue;
+        }
+        worker.closed.store(node.state.key(), node.depth);
+
+        MoveBuffer moves;
+        int nb_moves = node.state.actions(moves);
+        ++threadCounters().expanded;
+        if (worker.limits.expand()) {
+            worker.termination = worker.limits.reason();
+            stop_ = true;
+            break;
+        }
+        // the children are counted before anyone may receive them
+        outstanding_ += nb_moves;
+
+        for (int i = 0; i < nb_moves; ++i) {
+            if (worker.budget.exceeded()) {
+                worker.termination = Termination::MemLimit;
+                stop_ = true;
+                break;
+            }
+
+            HdaNode child = worker.arena[current];
+            child.state.execute(moves[i]);
+            child.parent_owner = worker.id;
+            child.parent = current;
+            child.depth = worker.arena[current].depth + 1;
+            child.action = moves[i];
+            ++threadCounters().generated;
+
+            if (child.state.isFinal()) {
+                auto goal = worker.arena.push(child);
+                if (!found_.exchange(true)) {
+                    goal_owner_ = worker.id;
+                    goal_ = goal;
+                }
+                stop_ = true;
+                break;
+            }
+
+            auto owner_id = owner(child.state.key(), workers_.size());
+            if (owner_id == worker.id) {
+                receive_(worker, child);
+            } else {
+                worker.outboxes[owner_id].push_back(child);
+                if (worker.outboxes[owner_id].size() >= hda_batch_size)
+                    flush_(worker, owner_id);
+            }
+        }
+        --outstanding_;
+
+        if (++nb_since_flush == hda_flush_period) {
+            for (int i = 0; i < static_cast<int>(workers_.size()); ++i)
+                flush_(worker, i);
+            nb_since_flush = 0;
+        }
+    }
+
+    worker.counters = threadCounters();
+    worker.time_taken = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0);
+}
+
+void HashDistributedAStar::reportStatistics(StrategyEvaluation *report) const {
+    if (report->workers.size() < workers_.size())
+        report->workers.resize(workers_.size());
+
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+        const auto &worker = *workers_[i];
+        report->workers[i].expanded += worker.counters.expanded;
+        report->workers[i].time_taken += worker.time_taken;
+
+        report->tt_hits += worker.closed.stats().hits;
+        report->tt_misses += worker.closed.stats().misses;
+        report->tt_evictions += worker.closed.stats().evictions;
+    }
+}
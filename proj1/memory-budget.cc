@@ -0,0 +1,29 @@
+#include "memory-budget.h"
+
+#include "memusage.h"
+
+#include <algorithm>
+
+MemoryBudget::MemoryBudget(std::size_t limit, std::size_t reserve, unsigned rss_check_period) :
+        limit_(limit),
+        reserve_(reserve),
+        rss_check_period_(rss_check_period),
+        nb_checks_(0),
+        charged_(0),
+        charged_at_anchor_(0),
+        rss_anchor_(0),
+        peak_(0) {
+    reset();
+}
+
+void MemoryBudget::reset() {
+    peak_ = 0;
+    anchor_();
+}
+
+void MemoryBudget::anchor_() {
+    nb_checks_ = 0;
+    rss_anchor_ = getCurrentRSS();
+    charged_at_anchor_ = charged_;
+    peak_ = std::max(peak_, rss_anchor_);
+}
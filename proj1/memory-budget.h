@@ -0,0 +1,52 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <cstddef>
+
+// headroom kept below the limit for whatever is not accounted
+inline constexpr std::size_t default_memory_reserve = 50'000'000;
+
+// Memory accounting for a single search. Containers charge the memory they
+// allocate, so exceeded() is a comparison on a counter. Every
+// rss_check_period calls the estimate is re-anchored to getCurrentRSS(),
+// which catches whatever was not charged (lazily touched pages, allocator
+// slack, containers of the standard library).
+class MemoryBudget {
+public:
+    MemoryBudget(std::size_t limit, std::size_t reserve = default_memory_reserve, unsigned rss_check_period = 8192) ;
+
+    // re-anchors to the current RSS, to be called at the start of a search
+    void reset();
+
+    void charge(std::size_t nb_bytes) { charged_ += nb_bytes; }
+    void release(std::size_t nb_bytes) { charged_ -= nb_bytes; }
+
+    bool exceeded() {
+        if (++nb_checks_ == rss_check_period_)
+            anchor_();
+
+        auto current = estimate();
+        if (current > peak_)
+            peak_ = current;
+        return current + reserve_ > limit_;
+    }
+
+    std::size_t estimate() const { return rss_anchor_ + charged_ - charged_at_anchor_; }
+    std::size_t peak() const { return peak_; }
+    std::size_t limit() const { return limit_; }
+
+private:
+    void anchor_();
+
+    std::size_t limit_;
+    std::size_t reserve_;
+    unsigned rss_check_period_;
+    unsigned nb_checks_;
+
+    std::size_t charged_;
+    std::size_t charged_at_anchor_;
+    std::size_t rss_anchor_;
+    std::size_t peak_;
+};
+
+#endif
@@ -122,3 +122,61 @@ size_t getCurrentRSS( )
     return (size_t)0L;          /* Unsupported. */
 #endif
 }
+
+
+
+
+
+/**
+ * Restarts the measurement of getPeakRSSSinceReset( ), which then
+ * reports the peak since this call. Only Linux supports this, elsewhere
+ * the peak keeps counting from the start of the process.
+ */
+void resetPeakRSS( )
+{
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+    /* Linux ---------------------------------------------------- */
+    FILE* fp = NULL;
+    if ( (fp = fopen( "/proc/self/clear_refs", "w" )) == NULL )
+        return;                 /* Can't open? */
+    fputs( "5", fp );
+    fclose( fp );
+#endif
+}
+
+
+
+
+
+/**
+ * Returns the peak resident set size since the last resetPeakRSS( ),
+ * measured in bytes. On Linux this is VmHWM of /proc/self/status, the
+ * high-water mark of the whole address space, which the reset clears.
+ * getPeakRSS( ) can not serve here: the kernel keeps the largest peak
+ * of every exited thread in ru_maxrss for the rest of the process.
+ * Elsewhere this is getPeakRSS( ).
+ */
+size_t getPeakRSSSinceReset( )
+{
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+    /* Linux ---------------------------------------------------- */
+    long hwm_kb = -1L;
+    char line[128];
+    FILE* fp = NULL;
+    if ( (fp = fopen( "/proc/self/status", "r" )) == NULL )
+        return getPeakRSS( );   /* Can't open? */
+    while ( fgets( line, sizeof(line), fp ) != NULL )
+    {
+        if ( sscanf( line, "VmHWM: %ld kB", &hwm_kb ) == 1 )
+            break;
+    }
+    fclose( fp );
+    if ( hwm_kb < 0 )
+        return getPeakRSS( );   /* Can't read? */
+    return (size_t)hwm_kb * 1024L;
+
+#else
+    /* other OSes ----------------------------------------------- */
+    return getPeakRSS( );
+#endif
+}
@@ -5,5 +5,8 @@
 
 size_t getPeakRSS();
 size_t getCurrentRSS();
+void resetPeakRSS();
+// the peak since the last resetPeakRSS()
+size_t getPeakRSSSinceReset();
 
 #endif
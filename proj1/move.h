@@ -5,10 +5,37 @@
 
 #include <utility>
 #include <iterator>
+#include <type_traits>
 
 bool moveLegal(const CardStorage *from, const CardStorage *to) ;
 void move(CardStorage *from, CardStorage *to) ;
 
+// Statically dispatched counterparts for a known (from, to) pair of
+// storage types. Overload resolution prefers these whenever both
+// pointers have a concrete (final) type; anything involving a
+// CardStorage pointer keeps using the virtual overloads above.
+template <typename From, typename To>
+inline constexpr bool static_storage_pair =
+    std::is_final_v<From> && std::is_base_of_v<CardStorage, From> &&
+    std::is_final_v<To> && std::is_base_of_v<CardStorage, To>;
+
+template <typename From, typename To, std::enable_if_t<static_storage_pair<From, To>, int> = 0>
+bool moveLegal(const From *from, const To *to) {
+    auto card_ref = from->From::topCard();
+    if (!card_ref.has_value())
+        return false;
+
+    return to->To::canAccept(*card_ref);
+}
+
+template <typename From, typename To, std::enable_if_t<static_storage_pair<From, To>, int> = 0>
+void move(From *from, To *to) {
+    if (!moveLegal(static_cast<const From *>(from), static_cast<const To *>(to)))
+        return;
+
+    to->To::acceptCard(*from->From::getCard());
+}
+
 using RawMove = std::pair<const CardStorage *, const CardStorage *>;
 
 template <typename T_ptr_It_from, typename T_ptr_It_to>
@@ -0,0 +1,54 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free queue with many producers and a single consumer
+// (D. Vyukov's linked list). push() is one atomic exchange, pop() never
+// touches shared state other than the link it follows.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head_(new Node), tail_(head_.load()) {}
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    ~MpscQueue() {
+        T item;
+        while (pop(&item))
+            ;
+        delete tail_;
+    }
+
+    // any thread
+    void push(T &&item) {
+        auto node = new Node;
+        node->item = std::move(item);
+        auto prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // consumer thread only, false if nothing has been pushed since
+    bool pop(T *item) {
+        auto next = tail_->next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+
+        *item = std::move(next->item);
+        delete tail_;
+        tail_ = next;
+        return true;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        T item;
+    };
+
+    std::atomic<Node *> head_;
+    Node *tail_;
+};
+
+#endif
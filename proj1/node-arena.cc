@@ -0,0 +1,12 @@
+#include "node-arena.h"
+
+#include <algorithm>
+
+std::vector<SearchAction> solutionPath(const NodeArena<SearchNode> &arena, NodeIndex goal) {
+    std::vector<SearchAction> solution;
+    for (auto idx = goal; arena[idx].parent != no_node; idx = arena[idx].parent)
+        solution.emplace_back(arena[idx].action);
+
+    std::reverse(solution.begin(), solution.end());
+    return solution;
+}
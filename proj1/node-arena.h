@@ -0,0 +1,76 @@
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include "search-interface.h"
+#include "memory-budget.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+using NodeIndex = std::uint32_t;
+inline constexpr NodeIndex no_node = std::numeric_limits<NodeIndex>::max();
+
+// Append-only storage of search nodes in fixed-size chunks.
+// Nodes never move, so references stay valid while the arena grows.
+// Chunks are kept by clear() and reused by the next search.
+// New chunks are charged to the budget, if one is given.
+template <typename Node>
+class NodeArena {
+    static_assert(std::is_trivially_destructible_v<Node>, "clear() does not run destructors");
+
+public:
+    explicit NodeArena(MemoryBudget *budget = nullptr) : budget_(budget) {}
+
+    NodeIndex push(const Node &node) {
+        if (size_ == chunks_.size() * chunk_size) {
+            chunks_.emplace_back(new Slot[chunk_size]);
+            if (budget_)
+                budget_->charge(chunk_size * sizeof(Node));
+        }
+
+        new (&slot_(size_)) Node(node);
+        return size_++;
+    }
+
+    Node &operator[](NodeIndex idx) { return *std::launder(reinterpret_cast<Node *>(&slot_(idx))); }
+    const Node &operator[](NodeIndex idx) const { return *std::launder(reinterpret_cast<const Node *>(&slot_(idx))); }
+
+    std::size_t size() const { return size_; }
+
+    // drops the nodes [size, size()), e.g. unused children or finished DFS subtrees
+    void truncate(std::size_t size) { if (size < size_) size_ = size; }
+    void clear() { size_ = 0; }
+
+    std::size_t capacityBytes() const { return chunks_.size() * chunk_size * sizeof(Node); }
+
+private:
+    static constexpr std::size_t chunk_bits = 16;
+    static constexpr std::size_t chunk_size = std::size_t{1} << chunk_bits;
+
+    struct alignas(Node) Slot {
+        std::byte bytes[sizeof(Node)];
+    };
+
+    Slot &slot_(NodeIndex idx) const { return chunks_[idx >> chunk_bits][idx & (chunk_size - 1)]; }
+
+    std::vector<std::unique_ptr<Slot[]>> chunks_;
+    std::size_t size_ = 0;
+    MemoryBudget *budget_;
+};
+
+struct SearchNode {
+    SearchState state;
+    NodeIndex parent;
+    std::uint32_t depth;
+    PackedMove action;
+};
+
+// Actions leading from the root to the given node
+std::vector<SearchAction> solutionPath(const NodeArena<SearchNode> &arena, NodeIndex goal) ;
+
+#endif
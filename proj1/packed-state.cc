@@ -0,0 +1,348 @@
+#include "packed-state.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+PackedCard packCard(const Card &card) {
+    return card.index();
+}
+
+Card unpackCard(PackedCard card) {
+    assert(card < nb_cards);
+    return {static_cast<Color>(packedColor(card)), packedValue(card)};
+}
+
+int locIndex(const Location &loc) {
+    switch (loc.cl) {
+        case LocationClass::FreeCells:
+            return loc.id;
+        case LocationClass::Stacks:
+            return first_stack_loc + loc.id;
+        case LocationClass::Homes:
+            return first_home_loc + loc.id;
+    }
+    throw std::out_of_range("Unknown location class");
+}
+
+Location locFromIndex(int loc_idx) {
+    if (loc_idx < first_stack_loc)
+        return {LocationClass::FreeCells, loc_idx};
+    else if (loc_idx < first_home_loc)
+        return {LocationClass::Stacks, loc_idx - first_stack_loc};
+    else
+        return {LocationClass::Homes, loc_idx - first_home_loc};
+}
+
+PackedState::PackedState(void) {
+    cards_.fill(no_card);
+    ends_.fill(0);
+    cells_.fill(no_card);
+    homes_.fill(no_card);
+}
+
+PackedState::PackedState(const GameState &gs) : PackedState() {
+    int pos = 0;
+    for (int i = 0; i < nb_stacks; ++i) {
+        for (const auto &card : gs.stacks[i].storage())
+            cards_[pos++] = packCard(card);
+        ends_[i] = pos;
+    }
+
+    for (int i = 0; i < nb_freecells; ++i) {
+        auto opt_card = gs.free_cells[i].topCard();
+        if (opt_card.has_value())
+            cells_[i] = packCard(*opt_card);
+    }
+
+    for (int i = 0; i < nb_homes; ++i) {
+        auto opt_card = gs.homes[i].topCard();
+        if (opt_card.has_value())
+            homes_[i] = packCard(*opt_card);
+    }
+}
+
+GameState PackedState::toGameState() const {
+    GameState gs;
+
+    for (int i = 0; i < nb_homes; ++i) {
+        if (homes_[i] == no_card)
+            continue;
+
+        auto color = static_cast<Color>(packedColor(homes_[i]));
+        for (int value = 1; value <= packedValue(homes_[i]); ++value)
+            gs.homes[i].acceptCard({color, value});
+    }
+
+    for (int i = 0; i < nb_freecells; ++i) {
+        if (cells_[i] != no_card)
+            gs.free_cells[i].acceptCard(unpackCard(cells_[i]));
+    }
+
+    for (int i = 0; i < nb_stacks; ++i) {
+        for (auto it = stackBegin(i); it != stackEnd(i); ++it)
+            gs.stacks[i].forceCard(unpackCard(*it));
+    }
+
+    return gs;
+}
+
+int PackedState::foundationLevel(int color) const {
+    for (auto top : homes_) {
+        if (top != no_card && packedColor(top) == color)
+            return packedValue(top);
+    }
+
+    return 0;
+}
+
+PackedCard PackedState::topCard(int loc_idx) const {
+    if (loc_idx < first_stack_loc) {
+        return cells_[loc_idx];
+    } else if (loc_idx < first_home_loc) {
+        auto stack_id = loc_idx - first_stack_loc;
+        return stackSize(stack_id) > 0 ? *(stackEnd(stack_id) - 1) : no_card;
+    } else {
+        return homes_[loc_idx - first_home_loc];
+    }
+}
+
+bool PackedState::canAccept(int loc_idx, PackedCard card) const {
+    auto top = topCard(loc_idx);
+
+    if (loc_idx < first_stack_loc) {
+        return top == no_card;
+    } else if (loc_idx < first_home_loc) {
+        if (top == no_card)
+            return true;
+        return cardSitsOnStack(top, card);
+    } else {
+        if (top == no_card)
+            return packedValue(card) == 1;
+        return cardSitsOnHome(top, card);
+    }
+}
+
+bool PackedState::moveLegal(int from_idx, int to_idx) const {
+    auto card = topCard(from_idx);
+    if (card == no_card)
+        return false;
+
+    return canAccept(to_idx, card);
+}
+
+int PackedState::runLength(int stack_loc) const {
+    auto stack_id = stack_loc - first_stack_loc;
+    auto begin = stackBegin(stack_id);
+    auto end = stackEnd(stack_id);
+    if (begin == end)
+        return 0;
+
+    int length = 1;
+    for (auto card = end - 1; card != begin && cardSitsOnStack(*(card - 1), *card); --card)
+        ++length;
+    return length;
+}
+
+int PackedState::superMoveCapacity(int to_idx) const {
+    int nb_free_cells = std::count(cells_.begin(), cells_.end(), no_card);
+    int nb_empty_stacks = 0;
+    for (int loc = first_stack_loc; loc < first_home_loc; ++loc) {
+        if (loc != to_idx && topCard(loc) == no_card)
+            ++nb_empty_stacks;
+    }
+
+    return (nb_free_cells + 1) << nb_empty_stacks;
+}
+
+// Size of the run to move onto the base, 0 if none fits
+static int superMoveCount(const PackedState &state, int from_idx, PackedCard base, int run_length, int capacity) {
+    auto limit = std::min(run_length, capacity);
+    if (base == no_card)
+        return limit;
+
+    auto bottom = packedValue(base) - 1;
+    auto top = packedValue(state.topCard(from_idx));
+    auto count = bottom - top + 1;
+    if (count < 1 || count > limit)
+        return 0;
+
+    auto stack_id = from_idx - first_stack_loc;
+    return cardSitsOnStack(base, *(state.stackEnd(stack_id) - count)) ? count : 0;
+}
+
+bool PackedState::superMoveLegal(int from_idx, int to_idx, int count) const {
+    bool stacks = from_idx >= first_stack_loc && from_idx < first_home_loc &&
+        to_idx >= first_stack_loc && to_idx < first_home_loc && from_idx != to_idx;
+    if (!stacks || count < 2)
+        return false;
+
+    auto expected = superMoveCount(*this, from_idx, topCard(to_idx), runLength(from_idx), superMoveCapacity(to_idx));
+    // onto an empty stack, any part of the run can go
+    return topCard(to_idx) == no_card ? count <= expected : count == expected;
+}
+
+void PackedState::move(int from_idx, int to_idx) {
+    put_(to_idx, take_(from_idx));
+}
+
+void PackedState::moveRun(int from_idx, int to_idx, int count) {
+    std::array<PackedCard, max_stack_size> run;
+    for (int i = count - 1; i >= 0; --i)
+        run[i] = take_(from_idx);
+    for (int i = 0; i < count; ++i)
+        put_(to_idx, run[i]);
+}
+
+int PackedState::legalMoves(MoveBuffer &moves, bool supermoves) const {
+    std::array<PackedCard, nb_locs> tops;
+    for (int i = 0; i < nb_locs; ++i)
+        tops[i] = topCard(i);
+
+    int nb_moves = 0;
+    for (int from = 0; from < nb_non_home_locs; ++from) {
+        auto card = tops[from];
+        if (card == no_card)
+            continue;
+
+        for (int to = 0; to < first_stack_loc; ++to) {
+            if (tops[to] == no_card)
+                moves[nb_moves++] = {from, to};
+        }
+
+        for (int to = first_stack_loc; to < first_home_loc; ++to) {
+            auto base = tops[to];
+            bool fits = base == no_card || cardSitsOnStack(base, card);
+            if (fits)
+                moves[nb_moves++] = {from, to};
+        }
+
+        for (int to = first_home_loc; to < nb_locs; ++to) {
+            auto base = tops[to];
+            bool fits = base == no_card ? packedValue(card) == 1 : cardSitsOnHome(base, card);
+            if (fits)
+                moves[nb_moves++] = {from, to};
+        }
+    }
+
+    if (!supermoves)
+        return nb_moves;
+
+    for (int from = first_stack_loc; from < first_home_loc; ++from) {
+        auto run_length = runLength(from);
+        if (run_length < 2)
+            continue;
+
+        for (int to = first_stack_loc; to < first_home_loc; ++to) {
+            if (to == from)
+                continue;
+
+            auto count = superMoveCount(*this, from, tops[to], run_length, superMoveCapacity(to));
+            // an empty stack takes the whole run only if it is not the whole stack
+            if (tops[to] == no_card && count == stackSize(from - first_stack_loc))
+                --count;
+            if (count >= 2)
+                moves[nb_moves++] = {from, to, count};
+        }
+    }
+
+    return nb_moves;
+}
+
+PackedCard PackedState::take_(int loc_idx) {
+    PackedCard card;
+
+    if (loc_idx < first_stack_loc) {
+        card = cells_[loc_idx];
+        cells_[loc_idx] = no_card;
+    } else if (loc_idx < first_home_loc) {
+        auto stack_id = loc_idx - first_stack_loc;
+        auto pos = ends_[stack_id] - 1;
+        auto nb_pooled = ends_[nb_stacks-1];
+        card = cards_[pos];
+        std::memmove(&cards_[pos], &cards_[pos+1], nb_pooled - pos - 1);
+        cards_[nb_pooled-1] = no_card;
+        for (int i = stack_id; i < nb_stacks; ++i)
+            --ends_[i];
+    } else {
+        auto &home = homes_[loc_idx - first_home_loc];
+        card = home;
+        home = packedValue(card) == 1 ? no_card : card - 1;
+    }
+
+    return card;
+}
+
+void PackedState::put_(int loc_idx, PackedCard card) {
+    if (loc_idx < first_stack_loc) {
+        cells_[loc_idx] = card;
+    } else if (loc_idx < first_home_loc) {
+        auto stack_id = loc_idx - first_stack_loc;
+        auto pos = ends_[stack_id];
+        auto nb_pooled = ends_[nb_stacks-1];
+        assert(nb_pooled < nb_cards);
+        std::memmove(&cards_[pos+1], &cards_[pos], nb_pooled - pos);
+        cards_[pos] = card;
+        for (int i = stack_id; i < nb_stacks; ++i)
+            ++ends_[i];
+    } else {
+        homes_[loc_idx - first_home_loc] = card;
+    }
+}
+
+bool PackedState::isFinal() const {
+    return std::all_of(
+        homes_.begin(),
+        homes_.end(),
+        [](PackedCard top){return top != no_card && packedValue(top) == king_value;}
+    );
+}
+
+CanonicalForm PackedState::canonical() const {
+    CanonicalForm form;
+    auto &order = form.real_loc;
+    for (int i = 0; i < nb_locs; ++i)
+        order[i] = i;
+
+    // no_card is the largest value, so empty locations sort last
+    auto by_top = [&](std::uint8_t a, std::uint8_t b){return topCard(a) < topCard(b);};
+    auto by_bottom = [&](std::uint8_t a, std::uint8_t b){
+        auto bottom = [&](int loc_idx){
+            auto stack_id = loc_idx - first_stack_loc;
+            return stackSize(stack_id) > 0 ? *stackBegin(stack_id) : no_card;
+        };
+        return bottom(a) < bottom(b);
+    };
+    std::sort(order.begin(), order.begin() + first_stack_loc, by_top);
+    std::sort(order.begin() + first_stack_loc, order.begin() + first_home_loc, by_bottom);
+    std::sort(order.begin() + first_home_loc, order.end(), by_top);
+
+    auto &result = form.state;
+    for (int i = 0; i < nb_freecells; ++i)
+        result.cells_[i] = cells_[order[i]];
+
+    int pos = 0;
+    for (int i = 0; i < nb_stacks; ++i) {
+        auto stack_id = order[first_stack_loc + i] - first_stack_loc;
+        pos = std::copy(stackBegin(stack_id), stackEnd(stack_id), result.cards_.begin() + pos) - result.cards_.begin();
+        result.ends_[i] = pos;
+    }
+
+    for (int i = 0; i < nb_homes; ++i)
+        result.homes_[i] = homes_[order[first_home_loc + i] - first_home_loc];
+
+    return form;
+}
+
+bool operator==(const PackedState &lhs, const PackedState &rhs) {
+    return std::memcmp(&lhs, &rhs, sizeof(PackedState)) == 0;
+}
+
+bool operator!=(const PackedState &lhs, const PackedState &rhs) {
+    return !(lhs == rhs);
+}
+
+bool operator<(const PackedState &lhs, const PackedState &rhs) {
+    return std::memcmp(&lhs, &rhs, sizeof(PackedState)) < 0;
+}
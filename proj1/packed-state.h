@@ -0,0 +1,138 @@
+#ifndef PACKED_STATE_H
+#define PACKED_STATE_H
+
+#include "game.h"
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+inline constexpr int nb_cards = king_value * nb_homes;
+
+// One byte per card, the CardIndex of card.h:
+// color * king_value + (value - 1).
+using PackedCard = CardIndex;
+inline constexpr PackedCard no_card = 0xff;
+
+PackedCard packCard(const Card &card) ;
+Card unpackCard(PackedCard card) ;
+
+static_assert(nb_cards == nb_card_indices);
+
+inline int packedColor(PackedCard card) { return static_cast<int>(cardColor(card)); }
+inline int packedValue(PackedCard card) { return cardValue(card); }
+inline bool packedIsRed(PackedCard card) { return cardIsRed(card); }
+
+// Locations are addressed by their position in GameState::all_storage:
+// free cells first, then stacks, then homes.
+inline constexpr int first_stack_loc = nb_freecells;
+inline constexpr int first_home_loc = nb_freecells + nb_stacks;
+inline constexpr int nb_non_home_locs = nb_freecells + nb_stacks;
+inline constexpr int nb_locs = nb_freecells + nb_stacks + nb_homes;
+
+int locIndex(const Location &loc) ;
+Location locFromIndex(int loc_idx) ;
+
+// A move between two location indices, packed into two bytes. A count
+// above one is a super-move of a run of cards between two stacks.
+class PackedMove {
+public:
+    PackedMove(void) : bits_(0) {}
+    PackedMove(int from_idx, int to_idx, int count = 1) : bits_((count - 1) << 8 | from_idx << 4 | to_idx) {}
+
+    int from() const { return bits_ >> 4 & 0xf; }
+    int to() const { return bits_ & 0xf; }
+    int count() const { return (bits_ >> 8) + 1; }
+
+private:
+    std::uint16_t bits_;
+};
+
+static_assert(nb_locs <= 16, "PackedMove stores location indices in 4 bits");
+
+// Any non-home top card can at most go to every location,
+// plus one super-move between every two stacks
+inline constexpr int max_nb_moves = nb_non_home_locs * nb_locs + nb_stacks * (nb_stacks - 1);
+using MoveBuffer = std::array<PackedMove, max_nb_moves>;
+
+struct CanonicalForm;
+
+// Allocation-free, trivially copyable encoding of a GameState.
+// All cascades share a single pool of nb_cards bytes, laid out back
+// to back with the bottom card first; cascade s occupies
+// [stackBegin(s), stackEnd(s)). Unused pool bytes are kept at no_card
+// so that two equal states are equal byte for byte.
+class PackedState {
+public:
+    PackedState(void) ;
+    explicit PackedState(const GameState &gs) ;
+    GameState toGameState() const;
+
+    PackedCard freeCell(int cell_id) const { return cells_[cell_id]; }
+    PackedCard homeTop(int home_id) const { return homes_[home_id]; }
+    int foundationLevel(int color) const;
+
+    const PackedCard *stackBegin(int stack_id) const {
+        return cards_.data() + (stack_id == 0 ? 0 : ends_[stack_id-1]);
+    }
+    const PackedCard *stackEnd(int stack_id) const { return cards_.data() + ends_[stack_id]; }
+    int stackSize(int stack_id) const { return stackEnd(stack_id) - stackBegin(stack_id); }
+
+    PackedCard topCard(int loc_idx) const;
+    bool canAccept(int loc_idx, PackedCard card) const;
+    bool moveLegal(int from_idx, int to_idx) const;
+
+    // Super-moves carry a run of alternating colors and descending values
+    // between two stacks, as many cards as the free cells and the empty
+    // stacks other than the target allow: (free cells + 1) * 2^(empty stacks)
+    int runLength(int stack_loc) const;
+    int superMoveCapacity(int to_idx) const;
+    bool superMoveLegal(int from_idx, int to_idx, int count) const;
+
+    // unchecked, the caller is responsible for legality
+    void move(int from_idx, int to_idx);
+    void moveRun(int from_idx, int to_idx, int count);
+
+    // Fills the buffer with all legal moves in the order of
+    // GameState::non_homes x GameState::all_storage, returns their number.
+    // With supermoves, the super-moves of two cards or more follow.
+    int legalMoves(MoveBuffer &moves, bool supermoves = false) const;
+
+    bool isFinal() const;
+
+    // Representative of all states equal up to a permutation of free cells,
+    // of stacks and of homes, see CanonicalForm
+    CanonicalForm canonical() const;
+
+    friend bool operator==(const PackedState &lhs, const PackedState &rhs) ;
+    friend bool operator<(const PackedState &lhs, const PackedState &rhs) ;
+
+private:
+    PackedCard take_(int loc_idx);
+    void put_(int loc_idx, PackedCard card);
+
+    std::array<PackedCard, nb_cards> cards_;
+    std::array<std::uint8_t, nb_stacks> ends_;
+    std::array<PackedCard, nb_freecells> cells_;
+    std::array<PackedCard, nb_homes> homes_;
+};
+
+static_assert(std::is_trivially_copyable_v<PackedState>);
+
+// Free cells sorted by card, stacks by their bottom card and homes by
+// their color, empty locations last. real_loc maps a location index of
+// the canonical state back to the location it came from.
+struct CanonicalForm {
+    PackedState state;
+    std::array<std::uint8_t, nb_locs> real_loc;
+
+    PackedMove realMove(PackedMove canonical_move) const {
+        return {real_loc[canonical_move.from()], real_loc[canonical_move.to()], canonical_move.count()};
+    }
+};
+
+bool operator==(const PackedState &lhs, const PackedState &rhs) ;
+bool operator!=(const PackedState &lhs, const PackedState &rhs) ;
+bool operator<(const PackedState &lhs, const PackedState &rhs) ;
+
+#endif
@@ -0,0 +1,96 @@
+#include "search-strategies.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+PortfolioSearch::PortfolioSearch(std::vector<std::unique_ptr<SearchStrategyItf>> &&strategies, Pick pick, std::chrono::milliseconds deadline) :
+        strategies_(std::move(strategies)),
+        pick_(pick),
+        deadline_(deadline) {
+    for (auto &strategy : strategies_)
+        strategy->setStopToken(stop_source_.token());
+}
+
+std::vector<SearchAction> PortfolioSearch::solve(const SearchState &init_state) {
+    if (init_state.isFinal())
+        return {};
+
+    stop_source_.reset();
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::size_t nb_finished = 0;
+    bool found = false;
+    std::vector<SearchAction> best;
+    std::vector<SearchCounters> counters(strategies_.size());
+
+    auto race = [&](std::size_t i) {
+        threadCounters() = {};
+        auto solution = strategies_[i]->solve(init_state);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        // a stopped strategy returns an empty solution
+        if (!solution.empty() && (!found || solution.size() < best.size())) {
+            best = std::move(solution);
+            found = true;
+        }
+        counters[i] = threadCounters();
+        ++nb_finished;
+        finished.notify_one();
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < strategies_.size(); ++i)
+        threads.emplace_back(race, i);
+
+    bool all_finished;
+    {
+        auto deadline = std::chrono::steady_clock::now() + deadline_;
+        auto done = [&]() {
+            return nb_finished == strategies_.size() ||
+                (pick_ == Pick::First && found) ||
+                (deadline_.count() > 0 && std::chrono::steady_clock::now() >= deadline) ||
+                stop_token_.stopRequested();
+        };
+
+        // wakes up now and then to notice the deadline or a stop of the portfolio itself
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!finished.wait_for(lock, std::chrono::milliseconds(10), done))
+            ;
+        all_finished = nb_finished == strategies_.size();
+    }
+
+    stop_source_.requestStop();
+    for (auto &thread : threads)
+        thread.join();
+
+    // the losers counted on their own threads
+    for (const auto &c : counters)
+        threadCounters() += c;
+
+    if (!found) {
+        // cut short by the deadline or by a stop of the portfolio itself
+        if (!all_finished)
+            return giveUp_(Termination::Timeout);
+        // the first member that hit a limit tells
+        for (const auto &strategy : strategies_) {
+            if (strategy->termination() != Termination::Exhausted)
+                return giveUp_(strategy->termination());
+        }
+        return giveUp_(Termination::Exhausted);
+    }
+
+    return best;
+}
+
+void PortfolioSearch::setLimits(SearchLimits limits) {
+    SearchStrategyItf::setLimits(limits);
+    for (auto &strategy : strategies_)
+        strategy->setLimits(limits);
+}
+
+void PortfolioSearch::reportStatistics(StrategyEvaluation *report) const {
+    for (const auto &strategy : strategies_)
+        strategy->reportStatistics(report);
+}
@@ -0,0 +1,83 @@
+#include "results-sink.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+std::string jsonString(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// quotes fields holding a separator or a quote, as RFC 4180 does
+std::string csvField(const std::string &text) {
+    if (text.find_first_of(",\"\n") == std::string::npos)
+        return text;
+
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+} // namespace
+
+ResultsSink::Format ResultsSink::formatFromName(const std::string &name) {
+    if (name == "jsonl")
+        return Format::JsonLines;
+    else if (name == "csv")
+        return Format::Csv;
+    else
+        throw std::invalid_argument("Unknown results format '" + name + "', supported are: jsonl, csv");
+}
+
+ResultsSink::ResultsSink(std::ostream &os, Format format, RunDescription run) :
+    os_(os), format_(format), run_(std::move(run)) {}
+
+void ResultsSink::write(const std::string &set, const std::vector<DealRecord> &deals) {
+    for (const auto &deal : deals) {
+        if (format_ == Format::JsonLines)
+            writeJson_(set, deal);
+        else
+            writeCsv_(set, deal);
+    }
+    os_.flush();
+}
+
+void ResultsSink::writeJson_(const std::string &set, const DealRecord &deal) {
+    os_ << "{\"seed\": " << run_.seed <<
+        ", \"set\": " << jsonString(set) <<
+        ", \"deal\": " << deal.deal <<
+        ", \"solver\": " << jsonString(run_.solver) <<
+        ", \"heuristic\": " << jsonString(run_.heuristic) <<
+        ", \"solved\": " << (deal.solved ? "true" : "false") <<
+        ", \"length\": " << deal.solution_length <<
+        ", \"expanded\": " << deal.expanded <<
+        ", \"generated\": " << deal.generated <<
+        ", \"time_us\": " << deal.time.count() <<
+        ", \"peak_rss\": " << deal.peak_rss <<
+        ", \"termination\": " << jsonString(terminationName(deal.termination)) << "}\n";
+}
+
+void ResultsSink::writeCsv_(const std::string &set, const DealRecord &deal) {
+    if (!header_written_) {
+        os_ << "seed,set,deal,solver,heuristic,solved,length,expanded,generated,time_us,peak_rss,termination\n";
+        header_written_ = true;
+    }
+
+    os_ << run_.seed << "," << csvField(set) << "," << deal.deal << "," <<
+        csvField(run_.solver) << "," << csvField(run_.heuristic) << "," <<
+        deal.solved << "," << deal.solution_length << "," <<
+        deal.expanded << "," << deal.generated << "," <<
+        deal.time.count() << "," << deal.peak_rss << "," <<
+        terminationName(deal.termination) << "\n";
+}
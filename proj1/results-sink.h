@@ -0,0 +1,40 @@
+#ifndef RESULTS_SINK_H
+#define RESULTS_SINK_H
+
+#include "evaluation-type.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// what is common to all deals of a run
+struct RunDescription {
+    int seed;
+    std::string solver;
+    std::string heuristic;
+};
+
+// Writes one record per deal, as JSON lines or as CSV with a header line.
+class ResultsSink {
+public:
+    enum class Format {JsonLines, Csv};
+
+    // throws std::invalid_argument for anything but "jsonl" and "csv"
+    static Format formatFromName(const std::string &name) ;
+
+    ResultsSink(std::ostream &os, Format format, RunDescription run) ;
+
+    // set names the kind of deals, e.g. "easy-20" or "random"
+    void write(const std::string &set, const std::vector<DealRecord> &deals) ;
+
+private:
+    void writeJson_(const std::string &set, const DealRecord &deal) ;
+    void writeCsv_(const std::string &set, const DealRecord &deal) ;
+
+    std::ostream &os_;
+    Format format_;
+    RunDescription run_;
+    bool header_written_ = false;
+};
+
+#endif
@@ -0,0 +1,10 @@
+#include "search-counters.h"
+
+SearchCounters &SearchCounters::operator+=(const SearchCounters &other) {
+    expanded += other.expanded;
+    generated += other.generated;
+    duplicates += other.duplicates;
+    auto_moves += other.auto_moves;
+    heuristic_calls += other.heuristic_calls;
+    return *this;
+}
@@ -0,0 +1,28 @@
+#ifndef SEARCH_COUNTERS_H
+#define SEARCH_COUNTERS_H
+
+#include <cstddef>
+
+inline constexpr std::size_t cache_line_size = 64;
+
+// Work done by a search. Each thread counts into its own instance, padded
+// to a cache line, so the hot path is a plain increment and parallel
+// workers never write to a shared line.
+struct alignas(cache_line_size) SearchCounters {
+    unsigned long long expanded = 0;
+    unsigned long long generated = 0;
+    unsigned long long duplicates = 0;
+    unsigned long long auto_moves = 0;
+    unsigned long long heuristic_calls = 0;
+
+    SearchCounters &operator+=(const SearchCounters &other);
+};
+
+// Counters of the calling thread. The driver resets them before a solve
+// and collects them after it.
+inline SearchCounters &threadCounters() {
+    static thread_local SearchCounters counters;
+    return counters;
+}
+
+#endif
@@ -5,8 +5,11 @@
 #include <algorithm>
 
 
-unsigned long long SearchState::nbExpanded() {
-    return SearchState::nb_expanded;
+SearchState::SearchState(const GameState &state, SearchOptions options) :
+        state_(state),
+        options_(options),
+        settled_(false) {
+	key_ = options.canonical ? canonicalKey(state_) : zobristKey(state_);
 }
 
 bool operator<(const SearchState &a, const SearchState &b) {
@@ -29,69 +32,222 @@ const Location& SearchAction::to() const {
     return to_;
 }
 
+int SearchAction::count() const {
+    return count_;
+}
+
 bool SearchState::execute(const SearchAction& action) {
-	auto from_ptr = ptrFromLoc(state_, action.from());
-	auto to_ptr = ptrFromLoc(state_, action.to());
+	return execute(PackedMove{locIndex(action.from()), locIndex(action.to()), action.count()});
+}
+
+bool SearchState::play_(PackedMove move) {
+	if (move.count() > 1) {
+		if (!state_.superMoveLegal(move.from(), move.to(), move.count()))
+			return false;
+		moveRun_(move.from(), move.to(), move.count());
+	} else {
+		if (!state_.moveLegal(move.from(), move.to()))
+			return false;
+		move_(move.from(), move.to());
+	}
 
-	if (!moveLegal(from_ptr, to_ptr))
+	return true;
+}
+
+// A move between non-home locations leaves the foundations as they were,
+// so in a settled state only the card it uncovered may have become safe
+static int touchedLocation(PackedMove move) {
+	return move.to() < first_home_loc ? move.from() : -1;
+}
+
+bool SearchState::execute(PackedMove move) {
+	if (!play_(move))
 		return false;
 
-	move(const_cast<CardStorage *>(from_ptr), const_cast<CardStorage *>(to_ptr));
+	runSafeMoves_(nullptr, touchedLocation(move));
 
-	runSafeMoves_();
+	return true;
+}
 
-    SearchState::nb_expanded++;
+bool SearchState::make(PackedMove move, UndoRecord *undo) {
+	undo->was_settled = settled_;
+	if (!play_(move))
+		return false;
+
+	undo->move = move;
+	undo->nb_auto_moves = 0;
+
+	runSafeMoves_(undo, touchedLocation(move));
 
 	return true;
 }
 
-void SearchState::runSafeMoves_() {
-	std::vector<RawMove> safe_moves;
-	while ((safe_moves = safeHomeMoves(state_)), safe_moves.size() > 0) {
-		const CardStorage *from = safe_moves[0].first;
-		const CardStorage *to = safe_moves[0].second;
+void SearchState::unmake(const UndoRecord &undo) {
+	for (int i = undo.nb_auto_moves - 1; i >= 0; --i)
+		move_(undo.auto_moves[i].to(), undo.auto_moves[i].from());
+
+	if (undo.move.count() > 1)
+		moveRun_(undo.move.to(), undo.move.from(), undo.move.count());
+	else
+		move_(undo.move.to(), undo.move.from());
+
+	settled_ = undo.was_settled;
+}
+
+namespace {
+
+// Foundation levels of a state, kept up to date while cards go home.
+// Packed counterpart of cardCouldGoHome() from game.cc: aces and twos are
+// always safe, other cards once both foundations of the other color are
+// at least one value below them.
+class Foundations {
+public:
+	explicit Foundations(const PackedState &state) {
+		level_.fill(0);
+		home_.fill(-1);
+		for (int loc = first_home_loc; loc < nb_locs; ++loc) {
+			auto top = state.topCard(loc);
+			if (top != no_card) {
+				level_[packedColor(top)] = packedValue(top);
+				home_[packedColor(top)] = loc;
+			}
+		}
+		firstEmptyHome_(state);
+		limits_();
+	}
+
+	// home the card can safely go to, -1 if none
+	int safeHome(PackedCard card) const {
+		auto value = packedValue(card);
+		auto color = packedColor(card);
+		if (value != level_[color] + 1 || value > limit_[packedIsRed(card)])
+			return -1;
+
+		return value == 1 ? first_empty_home_ : home_[color];
+	}
+
+	void raise(const PackedState &state, PackedCard card, int home_loc) {
+		auto color = packedColor(card);
+		++level_[color];
+		if (home_[color] < 0) {
+			home_[color] = home_loc;
+			firstEmptyHome_(state);
+		}
+		limits_();
+	}
+
+private:
+	void firstEmptyHome_(const PackedState &state) {
+		first_empty_home_ = -1;
+		for (int loc = first_home_loc; loc < nb_locs && first_empty_home_ < 0; ++loc) {
+			if (state.topCard(loc) == no_card)
+				first_empty_home_ = loc;
+		}
+	}
+
+	// highest safe value of red and black cards
+	void limits_() {
+		int min_red = std::min(level_[static_cast<int>(Color::Heart)], level_[static_cast<int>(Color::Diamond)]);
+		int min_black = std::min(level_[static_cast<int>(Color::Club)], level_[static_cast<int>(Color::Spade)]);
+		limit_[true] = std::max(2, min_black + 1);
+		limit_[false] = std::max(2, min_red + 1);
+	}
+
+	std::array<int, nb_homes> level_;
+	std::array<int, nb_homes> home_;
+	std::array<int, 2> limit_;
+	int first_empty_home_;
+};
+
+}
+
+// Same order as safeHomeMoves(): the first safe card goes to the first home
+// accepting it, then the scan starts over. A settled state had no safe card
+// left, so unless the foundations changed only the touched location is new.
+void SearchState::runSafeMoves_(UndoRecord *undo, int touched_loc) {
+	Foundations foundations(state_);
+
+	if (settled_ && touched_loc >= 0) {
+		auto card = state_.topCard(touched_loc);
+		if (card == no_card || foundations.safeHome(card) < 0)
+			return;
+	}
+	settled_ = true;
+
+	for (int from = 0; from < nb_non_home_locs; ) {
+		auto card = state_.topCard(from);
+		auto to = card == no_card ? -1 : foundations.safeHome(card);
+		if (to < 0) {
+			++from;
+			continue;
+		}
 
-		move(const_cast<CardStorage *>(from), const_cast<CardStorage *>(to));
+		move_(from, to);
+		foundations.raise(state_, card, to);
+		if (undo)
+			undo->auto_moves[undo->nb_auto_moves++] = {from, to};
+		++threadCounters().auto_moves;
+		from = 0;
 	}
 }
 
-bool SearchState::isFinal() const {
-	for (auto color : colors_list) {
-		if (!cardIsHome(state_, {color, king_value}))
-			return false;
+void SearchState::move_(int from_idx, int to_idx) {
+	if (options_.canonical) {
+		key_ ^= canonicalTop(state_, from_idx);
+		state_.move(from_idx, to_idx);
+		key_ ^= canonicalTop(state_, to_idx);
+	} else {
+		key_ ^= zobristTop(state_, from_idx);
+		state_.move(from_idx, to_idx);
+		key_ ^= zobristTop(state_, to_idx);
 	}
+}
 
-	return true;
+// The keys of the cards of a run are peeled off a scratch copy one by
+// one, the cards only get moved somewhere to uncover the next one
+static ZobristKey runKey(PackedState scratch, int loc_idx, int other_idx, int count, bool canonical) {
+	ZobristKey key = 0;
+	for (int i = 0; i < count; ++i) {
+		key ^= canonical ? canonicalTop(scratch, loc_idx) : zobristTop(scratch, loc_idx);
+		scratch.move(loc_idx, other_idx);
+	}
+	return key;
 }
 
-unsigned long long SearchState::nb_expanded = 0;
+void SearchState::moveRun_(int from_idx, int to_idx, int count) {
+	key_ ^= runKey(state_, from_idx, to_idx, count, options_.canonical);
+	state_.moveRun(from_idx, to_idx, count);
+	key_ ^= runKey(state_, to_idx, from_idx, count, options_.canonical);
+}
+
+bool SearchState::isFinal() const {
+	return state_.isFinal();
+}
+
+int SearchState::actions(MoveBuffer &moves) const {
+	return state_.legalMoves(moves, options_.supermoves);
+}
 
 std::vector<SearchAction> SearchState::actions() const {
-	auto raw_moves = availableMoves(
-		state_.non_homes.begin(),
-		state_.non_homes.end(),
-		state_.all_storage.begin(),
-		state_.all_storage.end()
-	);	
+	MoveBuffer buffer;
+	auto nb_moves = actions(buffer);
 
 	std::vector<SearchAction> moves;
-	std::transform(
-		raw_moves.begin(),
-		raw_moves.end(),
-		std::back_inserter(moves),
-		[&](RawMove raw_move){
-			return SearchAction{locFromPtr(state_, raw_move.first), locFromPtr(state_, raw_move.second)};
-		}
-	);
+	moves.reserve(nb_moves);
+	for (int i = 0; i < nb_moves; ++i)
+		moves.emplace_back(buffer[i]);
+
 	return moves;
 }
 
 std::ostream& operator<< (std::ostream& os, const SearchState & state) {
-	os << state.state_;
+	os << state.state_.toGameState();
 	return os;
 }
 
 std::ostream& operator<< (std::ostream& os, const SearchAction & action) {
 	os << action.from_ << " " << action.to_;
+	if (action.count_ > 1)
+		os << " x" << action.count_;
 	return os;
 }
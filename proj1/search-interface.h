@@ -3,8 +3,18 @@
 
 #include "move.h"
 #include "game.h"
+#include "packed-state.h"
+#include "zobrist.h"
+#include "evaluation-type.h"
+#include "search-counters.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <ostream>
+#include <type_traits>
 
 class SearchState;
 
@@ -12,45 +22,196 @@ class AStarHeuristicItf;
 
 class SearchAction {
 public:
-	SearchAction(Location from, Location to) : from_(from), to_(to) {} ;
+	// a count above one moves a run of cards between two stacks, see PackedState::superMoveLegal()
+	SearchAction(Location from, Location to, int count = 1) : from_(from), to_(to), count_(count) {} ;
+	explicit SearchAction(PackedMove move) : from_(locFromIndex(move.from())), to_(locFromIndex(move.to())), count_(move.count()) {} ;
 	SearchState execute(const SearchState& state) const ;
 
     friend std::ostream& operator<< (std::ostream& os, const SearchAction & action) ;
 
     const Location& from() const;
     const Location& to() const;
+    int count() const;
 private:
 	Location from_;
 	Location to_;
+	int count_;
+};
+
+// Everything make() changed: the move itself and the automatic home moves
+// that followed it. Every automatic move sends a card home, so there are
+// at most nb_cards of them.
+struct UndoRecord {
+	PackedMove move;
+	bool was_settled;
+	std::uint8_t nb_auto_moves;
+	std::array<PackedMove, nb_cards> auto_moves;
+};
+
+static_assert(std::is_trivially_copyable_v<UndoRecord>, "undo logs are plain arrays of records");
+
+struct SearchOptions {
+    // hash and compare states up to permutations of free cells, stacks and homes
+    bool canonical = false;
+    // generate super-moves of whole runs between stacks
+    bool supermoves = false;
 };
 
 class SearchState {
 public:
-    explicit SearchState(GameState state) : state_(state) {}
+    explicit SearchState(const GameState &state, SearchOptions options = {}) ;
 
 	bool isFinal() const;
 	std::vector<SearchAction> actions() const;
+	// allocation-free variant of actions(), returns the number of moves written
+	int actions(MoveBuffer &moves) const;
 
 	bool execute(const SearchAction &action);
-    static unsigned long long nbExpanded();
+	bool execute(PackedMove move);
+
+	// in-place variant of execute(), unmake() with the filled record reverts it
+	bool make(PackedMove move, UndoRecord *undo);
+	void unmake(const UndoRecord &undo);
+
+	// Zobrist key, maintained incrementally by execute(),
+	// permutation invariant in the canonical mode
+	ZobristKey key() const { return key_; }
+	const SearchOptions &options() const { return options_; }
+	GameState gameState() const { return state_.toGameState(); }
 
     friend std::ostream& operator<< (std::ostream& os, const SearchState & state) ;
     friend bool operator<(const SearchState &a, const SearchState &b) ;
     friend bool operator==(const SearchState &a, const SearchState &b) ;
     friend double compute_heuristic(const SearchState &state, const AStarHeuristicItf &heuristic);
-    friend size_t hash(const SearchState &state);
 
 private:
-	void runSafeMoves_();
-	GameState state_;
-    static unsigned long long nb_expanded;
+	bool play_(PackedMove move);
+	// touched_loc is the only location whose top card changed, -1 if unknown
+	void runSafeMoves_(UndoRecord *undo, int touched_loc);
+	void move_(int from_idx, int to_idx);
+	void moveRun_(int from_idx, int to_idx, int count);
+	ZobristKey key_;
+	PackedState state_;
+	SearchOptions options_;
+	// no safe move is left, true after the first move
+	bool settled_;
+};
+
+
+// Cooperative cancellation of a running solve(). Polling is a relaxed
+// load, a default-constructed token never requests a stop.
+class StopToken {
+public:
+    StopToken() = default;
+    explicit StopToken(const std::atomic<bool> *flag) : flag_(flag) {}
+
+    bool stopRequested() const { return flag_ && flag_->load(std::memory_order_relaxed); }
+
+private:
+    const std::atomic<bool> *flag_ = nullptr;
+};
+
+class StopSource {
+public:
+    StopToken token() const { return StopToken(&flag_); }
+    void requestStop() { flag_.store(true, std::memory_order_relaxed); }
+    void reset() { flag_.store(false, std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> flag_{false};
 };
 
+// Caps on a single solve(), zero leaves a cap out.
+struct SearchLimits {
+    std::chrono::milliseconds time{0};
+    unsigned long long nodes = 0;
+};
+
+// expansions between two readings of the clock by LimitCheck
+inline constexpr unsigned limit_clock_period = 256;
+
+// Enforces SearchLimits within one solve() on one thread. Cheap enough to be
+// called on every expansion, the clock is read only every limit_clock_period.
+class LimitCheck {
+public:
+    // share divides the node cap, for each of that many threads of one solve()
+    void start(const SearchLimits &limits, unsigned share = 1) {
+        nodes_ = limits.nodes > 0 ? std::max(limits.nodes / share, 1ull) : 0;
+        timed_ = limits.time.count() > 0;
+        if (timed_)
+            deadline_ = std::chrono::steady_clock::now() + limits.time;
+        nb_expanded_ = 0;
+        reached_ = false;
+    }
+
+    // counts one expansion, true once a cap is reached
+    bool expand() {
+        if (reached_)
+            return true;
+
+        ++nb_expanded_;
+        if (nodes_ > 0 && nb_expanded_ > nodes_) {
+            reached_ = true;
+            reason_ = Termination::NodeLimit;
+        } else if (timed_ && nb_expanded_ % limit_clock_period == 0 && std::chrono::steady_clock::now() >= deadline_) {
+            reached_ = true;
+            reason_ = Termination::Timeout;
+        }
+        return reached_;
+    }
+
+    bool reached() const { return reached_; }
+    // Timeout or NodeLimit, once reached()
+    Termination reason() const { return reason_; }
+
+private:
+    unsigned long long nodes_ = 0;
+    unsigned long long nb_expanded_ = 0;
+    bool timed_ = false;
+    std::chrono::steady_clock::time_point deadline_;
+    bool reached_ = false;
+    Termination reason_ = Termination::Timeout;
+};
 
 class SearchStrategyItf {
 public:
 	virtual std::vector<SearchAction> solve(const SearchState &init_state) =0 ;
+
+	// solve() counts its work into threadCounters() of the calling thread,
+	// strategies running helper threads add their counters there before returning
+
+	// adds strategy-specific counters of the last solve() to the report
+	virtual void reportStatistics([[maybe_unused]] StrategyEvaluation *report) const {}
+
+	// solve() gives up and returns no solution once the token requests a stop
+	virtual void setStopToken(StopToken token) { stop_token_ = token; }
+
+	// caps each following solve() by wall time and by expanded states
+	virtual void setLimits(SearchLimits limits) { limits_ = limits; }
+
+	// why the last solve() returned no solution
+	Termination termination() const { return termination_; }
+
 	virtual ~SearchStrategyItf() {}
+
+protected:
+	// every solve() path without a solution ends here
+	std::vector<SearchAction> giveUp_(Termination reason) {
+		termination_ = reason;
+		return {};
+	}
+
+	// Every solve() starts the check, counts its expansions with
+	// limit_check_.expand() and polls stopRequested_() where it would poll
+	// the stop token. stopReason_() tells why it has to give up.
+	void startLimits_() { limit_check_.start(limits_); }
+	bool stopRequested_() const { return limit_check_.reached() || stop_token_.stopRequested(); }
+	Termination stopReason_() const { return limit_check_.reached() ? limit_check_.reason() : Termination::Timeout; }
+
+	StopToken stop_token_;
+	SearchLimits limits_;
+	LimitCheck limit_check_;
+	Termination termination_ = Termination::Exhausted;
 };
 
 #endif
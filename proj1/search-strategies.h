@@ -3,7 +3,13 @@
 
 #include "search-interface.h"
 #include "game.h"
+#include "node-arena.h"
+#include "transposition-table.h"
+#include "memory-budget.h"
+#include "bucket-queue.h"
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -19,54 +25,254 @@ private:
 };
 
 
+// share of the memory limit given to the transposition tables
+inline constexpr size_t tt_memory_divisor = 4;
+
+inline TableConfig defaultTableConfig(size_t mem_limit) {
+    return {mem_limit / tt_memory_divisor, ReplacementPolicy::TwoTier};
+}
+
 class BreadthFirstSearch : public SearchStrategyItf {
 public:
-    BreadthFirstSearch(size_t mem_limit) : mem_limit_(mem_limit) {}
+    BreadthFirstSearch(size_t mem_limit) : BreadthFirstSearch(mem_limit, defaultTableConfig(mem_limit)) {}
+    BreadthFirstSearch(size_t mem_limit, const TableConfig &table) :
+        budget_(mem_limit),
+        arena_(&budget_),
+        closed_(table)
+        {}
 	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+	void reportStatistics(StrategyEvaluation *report) const override ;
 
 private:
-    size_t mem_limit_;
+    MemoryBudget budget_;
+    NodeArena<SearchNode> arena_;
+    TranspositionTable closed_;
 };
 
 class DepthFirstSearch : public SearchStrategyItf {
 public:
     DepthFirstSearch(int depth_limit, size_t mem_limit) :
-        depth_limit_(depth_limit), mem_limit_(mem_limit) {}
+        DepthFirstSearch(depth_limit, mem_limit, defaultTableConfig(mem_limit)) {}
+    DepthFirstSearch(int depth_limit, size_t mem_limit, const TableConfig &table) :
+        depth_limit_(depth_limit),
+        budget_(mem_limit),
+        arena_(&budget_),
+        closed_(table)
+        {}
 	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+	void reportStatistics(StrategyEvaluation *report) const override ;
+
 private:
     int depth_limit_;
-    size_t mem_limit_;
+    MemoryBudget budget_;
+    NodeArena<SearchNode> arena_;
+    TranspositionTable closed_;
 };
 
 
 class AStarHeuristicItf {
 public:
     virtual double distanceLowerBound(const GameState &state) const =0;
+
+    // Search-side entry point, override to avoid unpacking the state
+    virtual double distanceLowerBound(const PackedState &state) const {
+        return distanceLowerBound(state.toGameState());
+    }
+
+    // true if the estimates are always non-negative whole numbers,
+    // A* then keeps its open list in buckets instead of a heap
+    virtual bool integral() const { return false; }
+
+    virtual ~AStarHeuristicItf() {}
 };
 
 
 class AStarSearch : public SearchStrategyItf {
 public:
-    AStarSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic, size_t mem_limit) : 
+    AStarSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic, size_t mem_limit) :
+        AStarSearch(std::move(heuristic), mem_limit, defaultTableConfig(mem_limit)) {}
+    // weights above 1 make a weighted A* ordering the open list by g + weight * h
+    AStarSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic, size_t mem_limit, const TableConfig &table, double weight = 1.0) :
+        heuristic_(std::move(heuristic)),
+        weight_(weight),
+        budget_(mem_limit),
+        arena_(&budget_),
+        closed_(table)
+        {}
+	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+	void reportStatistics(StrategyEvaluation *report) const override ;
+
+private:
+    template <typename OpenList>
+    std::vector<SearchAction> search_(const SearchState &init_state, OpenList &open);
+
+    const std::unique_ptr<AStarHeuristicItf> heuristic_;
+    double weight_;
+    MemoryBudget budget_;
+    NodeArena<SearchNode> arena_;
+    TranspositionTable closed_;
+    BucketQueue<NodeIndex> buckets_;
+};
+
+// Anytime repairing A* (ARA*): a weighted A* which keeps searching after a
+// solution, lowering the weight by a step towards 1 after every one it
+// finds. The open list and the closed table are kept across weights, a
+// closed state is only expanded again when reached by a shorter path.
+// Returns the best solution once the open list runs dry, the time limit
+// passes or the search is stopped.
+class AnytimeAStar : public SearchStrategyItf {
+public:
+    // Searches for shorter solutions until the time limit or the per-deal
+    // time limit of setLimits(), whichever comes first; zero means none
+    AnytimeAStar(std::unique_ptr<AStarHeuristicItf> &&heuristic, size_t mem_limit, const TableConfig &table,
+            double initial_weight, double weight_step, std::chrono::milliseconds time_limit) :
         heuristic_(std::move(heuristic)),
-        mem_limit_(mem_limit)
+        initial_weight_(initial_weight),
+        weight_step_(weight_step),
+        time_limit_(time_limit),
+        budget_(mem_limit),
+        arena_(&budget_),
+        closed_(table)
+        {}
+	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+	void reportStatistics(StrategyEvaluation *report) const override ;
+
+private:
+    const std::unique_ptr<AStarHeuristicItf> heuristic_;
+    double initial_weight_;
+    double weight_step_;
+    std::chrono::milliseconds time_limit_;
+    MemoryBudget budget_;
+    NodeArena<SearchNode> arena_;
+    TranspositionTable closed_;
+    std::vector<SolutionImprovement> improvements_;
+};
+
+// Depth-first iterations with a growing bound on g + h. Walks a single
+// state with make/unmake, so memory is linear in the depth.
+class IterativeDeepeningAStar : public SearchStrategyItf {
+public:
+    explicit IterativeDeepeningAStar(std::unique_ptr<AStarHeuristicItf> &&heuristic) :
+        heuristic_(std::move(heuristic))
         {}
 	std::vector<SearchAction> solve(const SearchState &init_state) override ;
 
 private:
+    // returns the smallest f over the bound seen below the state, -1 once solved
+    double search_(SearchState &state, double bound);
+
+    const std::unique_ptr<AStarHeuristicItf> heuristic_;
+    std::vector<UndoRecord> path_;
+    std::vector<ZobristKey> path_keys_;
+};
+
+// Keeps the beam_width states of best heuristic value per depth and
+// drops the rest. All buffers are allocated by the constructor and reused
+// by every layer and deal, so the memory does not depend on the deal.
+// Gives up after max_depth layers.
+class BeamSearch : public SearchStrategyItf {
+public:
+    BeamSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic, std::size_t beam_width, std::size_t max_depth) ;
+	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+	void reportStatistics(StrategyEvaluation *report) const override ;
+
+private:
+    struct Candidate {
+        double heuristic;
+        std::uint32_t order;
+        std::uint32_t parent;
+        PackedMove move;
+        SearchState state;
+    };
+
+    // how a state of the next layer was reached from the previous one
+    struct Step {
+        std::uint32_t parent;
+        PackedMove move;
+    };
+
+    // heap order, so the worst candidate stays on top
+    static bool better_(const Candidate &lhs, const Candidate &rhs);
+
+    // lossy per-layer set of keys: a colliding key overwrites the slot
+    bool seen_(ZobristKey key);
+
+    const std::unique_ptr<AStarHeuristicItf> heuristic_;
+    std::size_t beam_width_;
+    std::size_t max_depth_;
+
+    std::vector<SearchState> layer_;
+    std::vector<Candidate> next_;
+    std::vector<Step> history_;
+    std::vector<ZobristKey> seen_keys_;
+    std::vector<std::uint32_t> seen_layers_;
+    std::uint32_t layer_stamp_;
+    std::size_t peak_layer_size_;
+};
+
+struct HdaNode;
+struct HdaWorker;
+
+// Hash-distributed A*: every state is owned by the worker thread picked
+// by its key. Each worker expands its own open list into its own closed
+// table and sends the children to their owners over lock-free queues.
+class HashDistributedAStar : public SearchStrategyItf {
+public:
+    HashDistributedAStar(std::unique_ptr<AStarHeuristicItf> &&heuristic, size_t mem_limit, const TableConfig &table, int nb_threads) ;
+    ~HashDistributedAStar();
+	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+	void reportStatistics(StrategyEvaluation *report) const override ;
+
+private:
+    void run_(HdaWorker &worker);
+    void receive_(HdaWorker &worker, const HdaNode &node);
+    void flush_(HdaWorker &worker, int owner);
+
     const std::unique_ptr<AStarHeuristicItf> heuristic_;
-    size_t mem_limit_;
+    std::vector<std::unique_ptr<HdaWorker>> workers_;
+
+    std::atomic<bool> stop_;
+    std::atomic<bool> found_;
+    // open entries plus children not received yet, the search ran dry at 0
+    std::atomic<long long> outstanding_;
+    int goal_owner_;
+    NodeIndex goal_;
+};
+
+// Races several strategies on the same deal, each on its own thread.
+// First returns the first solution found and stops the others, Shortest
+// waits for all of them (or the deadline) and returns the shortest one.
+class PortfolioSearch : public SearchStrategyItf {
+public:
+    enum class Pick {First, Shortest};
+
+    // a zero deadline means none
+    PortfolioSearch(std::vector<std::unique_ptr<SearchStrategyItf>> &&strategies, Pick pick, std::chrono::milliseconds deadline) ;
+	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+	void reportStatistics(StrategyEvaluation *report) const override ;
+	// every member is capped on its own
+	void setLimits(SearchLimits limits) override ;
+
+private:
+    std::vector<std::unique_ptr<SearchStrategyItf>> strategies_;
+    Pick pick_;
+    std::chrono::milliseconds deadline_;
+    StopSource stop_source_;
 };
 
 // beware, this has been proven to NOT be a valid heuristic!
 class OufOfHome_Pseudo : public AStarHeuristicItf {
 public:
     double distanceLowerBound(const GameState &state) const override;
+    double distanceLowerBound(const PackedState &state) const override;
+    bool integral() const override { return true; }
 };
 
 class StudentHeuristic : public AStarHeuristicItf {
 public:
+    using AStarHeuristicItf::distanceLowerBound;
     double distanceLowerBound(const GameState &state) const override;
+    bool integral() const override { return true; }
 };
 
 #endif
@@ -5,41 +5,64 @@
 #include <algorithm>
 
 double compute_heuristic(const SearchState &state, const AStarHeuristicItf &heuristic) {
+    ++threadCounters().heuristic_calls;
     return heuristic.distanceLowerBound(state.state_);
 }
 
+// reseeded for every deal, so results do not depend on the deals solved before
+static constexpr std::default_random_engine::result_type dummy_seed = 1337;
+
 DummySearch::DummySearch(size_t max_depth, size_t nb_attempts) :
         max_depth_(max_depth),
         nb_attempts_(nb_attempts),
-        rng_(1337) {
+        rng_(dummy_seed) {
 	; // just for initializer list	
 }
 
 std::vector<SearchAction> DummySearch::solve(const SearchState &init_state) {
-	for (size_t i = 0; i < nb_attempts_; ++i) {
-		std::vector<SearchAction> solution;
-		SearchState working_state(init_state);
+	rng_.seed(dummy_seed);
+	startLimits_();
+
+	// a single working state, rewound to the initial one between attempts
+	SearchState working_state(init_state);
+	std::vector<UndoRecord> undo_log;
+	undo_log.reserve(max_depth_);
+
+	for (size_t i = 0; i < nb_attempts_ && !stopRequested_(); ++i) {
+		while (!undo_log.empty()) {
+			working_state.unmake(undo_log.back());
+			undo_log.pop_back();
+		}
 
 		for (size_t depth = 0; depth < max_depth_ ; ++depth) {
-			auto actions = working_state.actions();
+			MoveBuffer moves;
+			auto nb_moves = working_state.actions(moves);
+			++threadCounters().expanded;
+			if (limit_check_.expand())
+				break;
 
 			// on a dead end
-			if (actions.size() == 0)
+			if (nb_moves == 0)
 				break; // start over
 
-			auto action = actions[0];
+			auto move = moves[0];
 			// actually, pick a random action
-			std::sample(actions.begin(), actions.end(), &action, 1, rng_);
+			std::sample(moves.begin(), moves.begin() + nb_moves, &move, 1, rng_);
 
-			solution.push_back(action);
-			working_state = action.execute(working_state);
+			undo_log.emplace_back();
+			working_state.make(move, &undo_log.back());
+			++threadCounters().generated;
 
-			if (working_state.isFinal())
+			if (working_state.isFinal()) {
+				std::vector<SearchAction> solution;
+				for (const auto &undo : undo_log)
+					solution.emplace_back(undo.move);
 				return solution;
+			}
 		}
 	}
 
-	return {};
+	return giveUp_(stopRequested_() ? stopReason_() : Termination::Exhausted);
 }
 
 double OufOfHome_Pseudo::distanceLowerBound(const GameState &state) const {
@@ -53,3 +76,14 @@ double OufOfHome_Pseudo::distanceLowerBound(const GameState &state) const {
     return cards_out_of_home;
 }
 
+
+double OufOfHome_Pseudo::distanceLowerBound(const PackedState &state) const {
+    int cards_out_of_home = nb_cards;
+    for (int i = 0; i < nb_homes; ++i) {
+        auto top = state.homeTop(i);
+        if (top != no_card)
+            cards_out_of_home -= packedValue(top);
+    }
+
+    return cards_out_of_home;
+}
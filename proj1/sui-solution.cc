@@ -1,109 +1,129 @@
 #include "search-strategies.h"
 #include <vector>
-#include "memusage.h"
 #include <algorithm>
-#include <unordered_set>
 #include <iostream>
 #include <deque>
-#include <memory>
-#include <set>
 #include <queue>
-
-#define SPACE_RESERVED 50000000
+#include <limits>
+#include <chrono>
+#include <cmath>
+#include <cassert>
 
 
 /*************************************************************
  * STRUCTURES *
  *************************************************************/
 
-struct StateBFS
+struct OpenAStar
 {
-	std::shared_ptr<SearchState> node;
-	std::shared_ptr<StateBFS> prevNode;
-	std::shared_ptr<SearchAction> actionFromPreviousState;
+	double priority;
+	NodeIndex node;
 };
 
-struct StateDFS
+struct OpenAStarCompare
 {
-	std::shared_ptr<SearchState> node;
-	std::shared_ptr<StateDFS> prevNode;
-	std::shared_ptr<SearchAction> actionFromPreviousState;
-	int index;
+	bool operator()(const OpenAStar &lhs, const OpenAStar &rhs) const
+	{
+		return lhs.priority > rhs.priority;
+	}
 };
 
-struct StateAStar
+// Binary heap ordered by f, for heuristics with fractional values
+struct HeapOpenList
 {
-	std::shared_ptr<SearchState> node;
-	std::shared_ptr<StateAStar> prevNode;
-	std::shared_ptr<SearchAction> actionFromPreviousState;
-	double priority;
-	int index;
+	static constexpr size_t entry_size = sizeof(OpenAStar);
+
+	void push(double f, [[maybe_unused]] double h, NodeIndex node)
+	{
+		heap.push({f, node});
+	}
+
+	NodeIndex pop()
+	{
+		NodeIndex node = heap.top().node;
+		heap.pop();
+		return node;
+	}
+
+	bool empty() const
+	{
+		return heap.empty();
+	}
+
+	std::priority_queue<OpenAStar, std::vector<OpenAStar>, OpenAStarCompare> heap;
 };
 
-struct StateAStarCompare
+// Buckets by f, lower h first inside a bucket, for integral heuristics
+struct BucketOpenList
 {
-	bool operator()(const std::shared_ptr<StateAStar> &lhs, const std::shared_ptr<StateAStar> &rhs) const
+	static constexpr size_t entry_size = sizeof(NodeIndex);
+
+	void push(double f, double h, NodeIndex node)
 	{
-		return lhs->priority > rhs->priority;
+		queue.push(static_cast<int>(f), static_cast<int>(h), node);
 	}
+
+	NodeIndex pop()
+	{
+		return queue.pop();
+	}
+
+	bool empty() const
+	{
+		return queue.empty();
+	}
+
+	BucketQueue<NodeIndex> &queue;
 };
 
 /*************************************************************
- * HASH FUNCTIONS *
+ * HELPERS *
  *************************************************************/
 
-template <typename StateType>
-struct StateEquality
+bool operator==(const SearchState &a, const SearchState &b)
 {
-	bool operator()(const std::shared_ptr<StateType> &lhs,
-					const std::shared_ptr<StateType> &rhs) const
+	if (a.key_ != b.key_)
 	{
-		return *lhs->node == *rhs->node;
+		return false;
 	}
-};
 
-template <typename StateType>
-struct StateHash
-{
-	size_t operator()(const std::shared_ptr<StateType> &state) const
+	if (a.options_.canonical)
 	{
-		return hash(*state->node);
+		return a.state_.canonical().state == b.state_.canonical().state;
 	}
-};
 
-bool operator==(const SearchState &a, const SearchState &b)
-{
 	return a.state_ == b.state_;
 }
 
-inline size_t hash_card(const Card &card)
-{
-	return std::hash<Color>()(card.color) ^
-		   (std::hash<int>()(card.value) << 1);
-}
-
-size_t hash(const SearchState &state)
+static bool isClosed(TranspositionTable &closed, const SearchNode &node)
 {
-	size_t hash = 0;
-
-	for (const auto &freeCell : state.state_.free_cells)
+	if (!closed.contains(node.state.key(), node.depth))
 	{
-		auto card = freeCell.topCard();
-		if (card.has_value())
-		{
-			hash ^= hash_card(card.value());
-		}
+		return false;
 	}
 
-	for (const auto &tableauStack : state.state_.stacks)
-	{
-		for (const auto &card : tableauStack.storage())
-		{
-			hash ^= hash_card(card) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-		}
-	}
+	++threadCounters().duplicates;
+	return true;
+}
 
-	return hash;
+static void addStatistics(const TranspositionTable &closed, StrategyEvaluation *report)
+{
+	report->tt_hits += closed.stats().hits;
+	report->tt_misses += closed.stats().misses;
+	report->tt_evictions += closed.stats().evictions;
+}
+
+// Places a copy of the parent into the arena and applies the move to it
+static NodeIndex pushChild(NodeArena<SearchNode> &arena, NodeIndex parent, PackedMove move)
+{
+	auto child = arena.push(arena[parent]);
+	auto &node = arena[child];
+	node.state.execute(move);
+	node.parent = parent;
+	node.depth = arena[parent].depth + 1;
+	node.action = move;
+	++threadCounters().generated;
+	return child;
 }
 
 /*************************************************************
@@ -112,75 +132,84 @@ size_t hash(const SearchState &state)
 
 std::vector<SearchAction> BreadthFirstSearch::solve(const SearchState &init_state)
 {
+	startLimits_();
 	if (init_state.isFinal())
 	{
 		return {};
 	}
 
-	std::deque<std::shared_ptr<StateBFS>> open;
-	std::unordered_set<std::shared_ptr<StateBFS>, StateHash<StateBFS>, StateEquality<StateBFS>> closed;
+	budget_.reset();
+	arena_.clear();
+	closed_.clear();
+	std::deque<NodeIndex> open;
 
 	// Initial state
-	std::shared_ptr<StateBFS> initState = std::make_shared<StateBFS>();
-	initState->node = std::make_shared<SearchState>(init_state);
-	open.push_back(initState);
+	open.push_back(arena_.push({init_state, no_node, 0, {}}));
+	budget_.charge(sizeof(NodeIndex));
 
-	bool found = false;
+	NodeIndex goal = no_node;
 	// Cycle through the tree
-	while (!open.empty() && !found)
+	while (!open.empty() && goal == no_node)
 	{
-		std::shared_ptr<StateBFS> currentState = std::move(open.back());
+		NodeIndex currentState = open.back();
 		open.pop_back();
+		budget_.release(sizeof(NodeIndex));
 
-		if (closed.find(currentState) != closed.end())
+		if (isClosed(closed_, arena_[currentState]))
 		{
 			continue;
 		}
 
-		closed.insert(currentState);
+		closed_.store(arena_[currentState].state.key(), arena_[currentState].depth);
 
 		// Save all child-nodes to open
-		for (auto &action : currentState->node->actions())
+		MoveBuffer moves;
+		int nb_moves = arena_[currentState].state.actions(moves);
+		++threadCounters().expanded;
+		limit_check_.expand();
+		for (int i = 0; i < nb_moves; ++i)
 		{
-			if (getCurrentRSS() + SPACE_RESERVED > mem_limit_)
+			if (budget_.exceeded())
 			{
-				return {};
+				return giveUp_(Termination::MemLimit);
+			}
+			if (stopRequested_())
+			{
+				return giveUp_(stopReason_());
 			}
 
-			std::shared_ptr<StateBFS> nextState = std::make_shared<StateBFS>();
-			nextState->node = std::make_shared<SearchState>(action.execute(*currentState->node));
-			nextState->actionFromPreviousState = std::make_shared<SearchAction>(action);
-			nextState->prevNode = currentState;
+			NodeIndex nextState = pushChild(arena_, currentState, moves[i]);
 
-			if (nextState->node->isFinal())
+			if (arena_[nextState].state.isFinal())
 			{
-				found = true;
-				open.push_front(std::move(nextState));
+				goal = nextState;
 				break;
 			}
 			// Insert only not visited nodes
-			else if (closed.find(nextState) == closed.end())
+			else if (!isClosed(closed_, arena_[nextState]))
+			{
+				open.push_front(nextState);
+				budget_.charge(sizeof(NodeIndex));
+			}
+			else
 			{
-				open.push_front(std::move(nextState));
+				arena_.truncate(nextState);
 			}
 		}
 	}
 
 	// Create path to final node
-	std::vector<SearchAction> solution = {};
-	if (!closed.empty() && open.front()->node->isFinal())
+	if (goal != no_node)
 	{
-		std::shared_ptr<StateBFS> actualState = open.front();
-		while (actualState->node != initState->node)
-		{
-			solution.push_back(*(actualState->actionFromPreviousState));
-			actualState = actualState->prevNode;
-		}
-		reverse(solution.begin(), solution.end());
-		return solution;
+		return solutionPath(arena_, goal);
 	}
 
-	return {};
+	return giveUp_(Termination::Exhausted);
+}
+
+void BreadthFirstSearch::reportStatistics(StrategyEvaluation *report) const
+{
+	addStatistics(closed_, report);
 }
 
 /*************************************************************
@@ -189,72 +218,90 @@ std::vector<SearchAction> BreadthFirstSearch::solve(const SearchState &init_stat
 
 std::vector<SearchAction> DepthFirstSearch::solve(const SearchState &init_state)
 {
+	startLimits_();
 	if (init_state.isFinal())
 	{
 		return {};
 	}
 
-	std::deque<std::shared_ptr<StateDFS>> open;
+	budget_.reset();
+	arena_.clear();
+	closed_.clear();
+	std::vector<NodeIndex> open;
 
 	// Initial state
-	std::shared_ptr<StateDFS> initState = std::make_shared<StateDFS>();
-	initState->node = std::make_shared<SearchState>(init_state);
-	initState->index = 0;
-	open.push_back(initState);
+	open.push_back(arena_.push({init_state, no_node, 0, {}}));
+	budget_.charge(sizeof(NodeIndex));
 
-	bool found = false;
+	NodeIndex goal = no_node;
 	// Cycle through the tree
-	while (!open.empty() && !found)
+	while (!open.empty() && goal == no_node)
 	{
-		std::shared_ptr<StateDFS> currentState = std::move(open.back());
+		NodeIndex currentState = open.back();
 		open.pop_back();
+		budget_.release(sizeof(NodeIndex));
+
+		// Nodes behind the popped one belong to finished subtrees
+		arena_.truncate(currentState + 1);
+
+		if (isClosed(closed_, arena_[currentState]))
+		{
+			continue;
+		}
 
-		if (currentState->index < depth_limit_)
+		closed_.store(arena_[currentState].state.key(), arena_[currentState].depth);
+
+		if (arena_[currentState].depth < static_cast<std::uint32_t>(depth_limit_))
 		{
 			// Save all child-nodes to open
-			for (auto action : currentState->node->actions())
+			MoveBuffer moves;
+			int nb_moves = arena_[currentState].state.actions(moves);
+			++threadCounters().expanded;
+			limit_check_.expand();
+			for (int i = 0; i < nb_moves; ++i)
 			{
-				if (getCurrentRSS() + SPACE_RESERVED > mem_limit_)
+				if (budget_.exceeded())
+				{
+					return giveUp_(Termination::MemLimit);
+				}
+				if (stopRequested_())
 				{
-					return {};
+					return giveUp_(stopReason_());
 				}
 
-				std::shared_ptr<StateDFS> nextState = std::make_shared<StateDFS>();
-				nextState->node = std::make_shared<SearchState>(action.execute(*currentState->node));
-				nextState->actionFromPreviousState = std::make_shared<SearchAction>(action);
-				nextState->prevNode = currentState;
-				nextState->index = currentState->index + 1;
+				NodeIndex nextState = pushChild(arena_, currentState, moves[i]);
 
-				if (nextState->node->isFinal())
+				if (arena_[nextState].state.isFinal())
 				{
-					found = true;
-					open.push_front(std::move(nextState));
+					goal = nextState;
 					break;
 				}
-				open.push_back(std::move(nextState));
+				// Insert only nodes not visited at this depth or above
+				else if (!isClosed(closed_, arena_[nextState]))
+				{
+					open.push_back(nextState);
+					budget_.charge(sizeof(NodeIndex));
+				}
+				else
+				{
+					arena_.truncate(nextState);
+				}
 			}
 		}
-		else
-		{
-			open.pop_back();
-		}
 	}
 
 	// Create path to final node
-	std::vector<SearchAction> solution = {};
-	if (!open.empty() && open.front()->node->isFinal())
+	if (goal != no_node)
 	{
-		std::shared_ptr<StateDFS> actualState = move(open.front());
-		while (actualState->node != initState->node)
-		{
-			solution.push_back(*(actualState->actionFromPreviousState));
-			actualState = actualState->prevNode;
-		}
-		reverse(solution.begin(), solution.end());
-		return solution;
+		return solutionPath(arena_, goal);
 	}
 
-	return {};
+	return giveUp_(Termination::Exhausted);
+}
+
+void DepthFirstSearch::reportStatistics(StrategyEvaluation *report) const
+{
+	addStatistics(closed_, report);
 }
 
 /*************************************************************
@@ -287,9 +334,10 @@ double NotInOder(const GameState &state) {
 // Count the number of cards that are not at the foundation piles
 double NumCardsNotAtFoundations(const GameState &state) {
     double count = 0;
-    const auto &firstCard = state.stacks[0].storage().back();
+    // A free cell refuses exactly when it is taken, whatever the card; the
+    // top card of the first stack used to probe them, which may be empty
     for (const auto &free_cells : state.free_cells) {
-        if (!free_cells.canAccept(firstCard)) //how many cards there are
+        if (free_cells.topCard().has_value()) //how many cards there are
             count++;
     }
     for (const auto &stack : state.stacks) {
@@ -308,84 +356,474 @@ double StudentHeuristic::distanceLowerBound(const GameState &state) const
 
 std::vector<SearchAction> AStarSearch::solve(const SearchState &init_state)
 {
+	startLimits_();
 	if (init_state.isFinal())
 	{
 		return {};
 	}
 
-	std::priority_queue<std::shared_ptr<StateAStar>,
-						std::vector<std::shared_ptr<StateAStar>>,
-						StateAStarCompare>
-		openPrio;
+	// whole weights keep the priorities integral
+	if (heuristic_->integral() && weight_ == std::floor(weight_))
+	{
+		buckets_.clear();
+		BucketOpenList open{buckets_};
+		return search_(init_state, open);
+	}
+
+	HeapOpenList open;
+	return search_(init_state, open);
+}
 
-	std::unordered_set<std::shared_ptr<StateAStar>,
-					   StateHash<StateAStar>,
-					   StateEquality<StateAStar>>
-		closed;
+template <typename OpenList>
+std::vector<SearchAction> AStarSearch::search_(const SearchState &init_state, OpenList &openPrio)
+{
+	budget_.reset();
+	arena_.clear();
+	closed_.clear();
 
 	// Initial state
-	std::shared_ptr<StateAStar> initState = std::make_shared<StateAStar>();
-	initState->node = std::make_shared<SearchState>(init_state);
-	initState->index = 0;
-	openPrio.push(initState);
+	openPrio.push(0.0, 0.0, arena_.push({init_state, no_node, 0, {}}));
+	budget_.charge(OpenList::entry_size);
 
-	bool found = false;
+	NodeIndex goal = no_node;
 	// Cycle through the tree
-	while (!openPrio.empty() && !found)
+	while (!openPrio.empty() && goal == no_node)
 	{
-		std::shared_ptr<StateAStar> currentState = std::move(openPrio.top());
-		openPrio.pop();
+		NodeIndex currentState = openPrio.pop();
+		budget_.release(OpenList::entry_size);
 
-		if (closed.find(currentState) != closed.end())
+		if (isClosed(closed_, arena_[currentState]))
 		{
 			continue;
 		}
 
-		closed.insert(currentState);
+		closed_.store(arena_[currentState].state.key(), arena_[currentState].depth);
 
 		// Save all child-nodes to openPrio
-		for (auto &action : currentState->node->actions())
+		MoveBuffer moves;
+		int nb_moves = arena_[currentState].state.actions(moves);
+		++threadCounters().expanded;
+		limit_check_.expand();
+		for (int i = 0; i < nb_moves; ++i)
 		{
-			if (getCurrentRSS() + SPACE_RESERVED > mem_limit_)
+			if (budget_.exceeded())
+			{
+				return giveUp_(Termination::MemLimit);
+			}
+			if (stopRequested_())
 			{
-				return {};
+				return giveUp_(stopReason_());
 			}
 
-			std::shared_ptr<StateAStar> nextState = std::make_shared<StateAStar>();
-			nextState->node = std::make_shared<SearchState>(action.execute(*currentState->node));
-			nextState->actionFromPreviousState = std::make_shared<SearchAction>(action);
-			nextState->prevNode = currentState;
+			NodeIndex nextState = pushChild(arena_, currentState, moves[i]);
 
-			if (nextState->node->isFinal())
+			if (arena_[nextState].state.isFinal())
 			{
-				found = true;
-				openPrio.push(std::move(nextState));
+				goal = nextState;
 				break;
 			}
 			// Insert only not visited nodes
-			else if (closed.find(nextState) == closed.end())
+			else if (!isClosed(closed_, arena_[nextState]))
 			{
-				auto heuristic = compute_heuristic(*nextState->node, *heuristic_);
-				nextState->index = currentState->index + 1;
-				nextState->priority = heuristic + nextState->index;
-				openPrio.push(std::move(nextState));
+				auto heuristic = compute_heuristic(arena_[nextState].state, *heuristic_);
+				openPrio.push(weight_ * heuristic + arena_[nextState].depth, heuristic, nextState);
+				budget_.charge(OpenList::entry_size);
+			}
+			else
+			{
+				arena_.truncate(nextState);
 			}
 		}
 	}
 
 	// Create path to final node
-	std::vector<SearchAction> solution = {};
-	if (!closed.empty() && openPrio.top()->node->isFinal())
+	if (goal != no_node)
+	{
+		return solutionPath(arena_, goal);
+	}
+
+	return giveUp_(Termination::Exhausted);
+}
+
+void AStarSearch::reportStatistics(StrategyEvaluation *report) const
+{
+	addStatistics(closed_, report);
+}
+
+/*************************************************************
+ * ARA STAR *
+ *************************************************************/
+
+struct OpenAnytime
+{
+	double priority;
+	double heuristic;
+	NodeIndex node;
+};
+
+// std::push_heap keeps the greatest element on top, so lower f wins, then lower h
+struct OpenAnytimeCompare
+{
+	bool operator()(const OpenAnytime &lhs, const OpenAnytime &rhs) const
+	{
+		return lhs.priority > rhs.priority || (lhs.priority == rhs.priority && lhs.heuristic > rhs.heuristic);
+	}
+};
+
+std::vector<SearchAction> AnytimeAStar::solve(const SearchState &init_state)
+{
+	// The search keeps tightening the weight until the earlier of its own
+	// time limit and the per-deal one, the limit check watches the clock
+	SearchLimits limits = limits_;
+	if (time_limit_.count() > 0 && (limits.time.count() == 0 || time_limit_ < limits.time))
+	{
+		limits.time = time_limit_;
+	}
+	limit_check_.start(limits);
+	improvements_.clear();
+	if (init_state.isFinal())
+	{
+		return {};
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	budget_.reset();
+	arena_.clear();
+	closed_.clear();
+	std::vector<OpenAnytime> open;
+	double weight = initial_weight_;
+
+	// Initial state
+	auto root = arena_.push({init_state, no_node, 0, {}});
+	auto root_heuristic = compute_heuristic(arena_[root].state, *heuristic_);
+	open.push_back({weight * root_heuristic, root_heuristic, root});
+	budget_.charge(sizeof(OpenAnytime));
+
+	NodeIndex goal = no_node;
+	std::uint32_t goal_depth = std::numeric_limits<std::uint32_t>::max();
+	bool out_of_resources = false;
+
+	// Cycle through the tree until nothing can beat the best solution
+	while (!open.empty() && !out_of_resources)
 	{
-		std::shared_ptr<StateAStar> actualState = openPrio.top();
-		while (actualState->node != initState->node)
+		std::pop_heap(open.begin(), open.end(), OpenAnytimeCompare());
+		NodeIndex currentState = open.back().node;
+		open.pop_back();
+		budget_.release(sizeof(OpenAnytime));
+
+		// Children would be no shorter than the best solution
+		if (arena_[currentState].depth + 1 >= goal_depth || isClosed(closed_, arena_[currentState]))
 		{
-			solution.push_back(*(actualState->actionFromPreviousState));
-			actualState = actualState->prevNode;
+			continue;
 		}
-		reverse(solution.begin(), solution.end());
-		return solution;
+
+		closed_.store(arena_[currentState].state.key(), arena_[currentState].depth);
+
+		// Save all child-nodes to open
+		MoveBuffer moves;
+		int nb_moves = arena_[currentState].state.actions(moves);
+		++threadCounters().expanded;
+		limit_check_.expand();
+		for (int i = 0; i < nb_moves; ++i)
+		{
+			if (budget_.exceeded() || stopRequested_())
+			{
+				out_of_resources = true;
+				break;
+			}
+
+			NodeIndex nextState = pushChild(arena_, currentState, moves[i]);
+
+			if (arena_[nextState].state.isFinal())
+			{
+				goal = nextState;
+				goal_depth = arena_[nextState].depth;
+				auto elapsed = std::chrono::steady_clock::now() - start;
+				improvements_.push_back({0, goal_depth, std::chrono::duration_cast<std::chrono::microseconds>(elapsed)});
+
+				// Tighten the weight and reorder what is left
+				if (weight > 1.0)
+				{
+					weight = std::max(1.0, weight - weight_step_);
+					for (auto &entry : open)
+					{
+						entry.priority = arena_[entry.node].depth + weight * entry.heuristic;
+					}
+					std::make_heap(open.begin(), open.end(), OpenAnytimeCompare());
+				}
+
+				// Siblings are no shorter
+				break;
+			}
+			// Insert only not visited nodes
+			else if (!isClosed(closed_, arena_[nextState]))
+			{
+				auto heuristic = compute_heuristic(arena_[nextState].state, *heuristic_);
+				open.push_back({arena_[nextState].depth + weight * heuristic, heuristic, nextState});
+				std::push_heap(open.begin(), open.end(), OpenAnytimeCompare());
+				budget_.charge(sizeof(OpenAnytime));
+			}
+			else
+			{
+				arena_.truncate(nextState);
+			}
+		}
+	}
+
+	// Create path to the best final node
+	if (goal != no_node)
+	{
+		return solutionPath(arena_, goal);
+	}
+
+	if (out_of_resources)
+	{
+		return giveUp_(budget_.exceeded() ? Termination::MemLimit : stopReason_());
+	}
+	return giveUp_(Termination::Exhausted);
+}
+
+void AnytimeAStar::reportStatistics(StrategyEvaluation *report) const
+{
+	addStatistics(closed_, report);
+	report->improvements.insert(report->improvements.end(), improvements_.begin(), improvements_.end());
+}
+
+/*************************************************************
+ * BEAM SEARCH *
+ *************************************************************/
+
+// slots of the per-layer key set for every state of the beam
+static constexpr std::size_t beam_seen_ratio = 4;
+
+bool BeamSearch::better_(const Candidate &lhs, const Candidate &rhs)
+{
+	return lhs.heuristic < rhs.heuristic || (lhs.heuristic == rhs.heuristic && lhs.order < rhs.order);
+}
+
+BeamSearch::BeamSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic, std::size_t beam_width, std::size_t max_depth) :
+	heuristic_(std::move(heuristic)),
+	beam_width_(beam_width),
+	max_depth_(max_depth),
+	history_(beam_width * max_depth),
+	layer_stamp_(0),
+	peak_layer_size_(0)
+{
+	assert(beam_width_ > 0 && max_depth_ > 0);
+	layer_.reserve(beam_width_);
+	next_.reserve(beam_width_);
+
+	std::size_t nb_slots = 1;
+	while (nb_slots < beam_seen_ratio * beam_width_)
+	{
+		nb_slots *= 2;
+	}
+	seen_keys_.resize(nb_slots);
+	seen_layers_.resize(nb_slots);
+}
+
+bool BeamSearch::seen_(ZobristKey key)
+{
+	auto slot = key & (seen_keys_.size() - 1);
+	if (seen_layers_[slot] == layer_stamp_ && seen_keys_[slot] == key)
+	{
+		return true;
+	}
+
+	seen_layers_[slot] = layer_stamp_;
+	seen_keys_[slot] = key;
+	return false;
+}
+
+std::vector<SearchAction> BeamSearch::solve(const SearchState &init_state)
+{
+	startLimits_();
+	peak_layer_size_ = 0;
+	if (init_state.isFinal())
+	{
+		return {};
+	}
+
+	layer_.clear();
+	layer_.push_back(init_state);
+
+	for (std::size_t depth = 0; depth < max_depth_; ++depth)
+	{
+		next_.clear();
+		// a fresh key set, stamp 0 is what the slots start with
+		if (++layer_stamp_ == 0)
+		{
+			std::fill(seen_layers_.begin(), seen_layers_.end(), 0);
+			layer_stamp_ = 1;
+		}
+		std::uint32_t order = 0;
+
+		for (std::uint32_t parent = 0; parent < layer_.size(); ++parent)
+		{
+			if (stopRequested_())
+			{
+				return giveUp_(stopReason_());
+			}
+
+			MoveBuffer moves;
+			int nb_moves = layer_[parent].actions(moves);
+			++threadCounters().expanded;
+			limit_check_.expand();
+			for (int i = 0; i < nb_moves; ++i)
+			{
+				SearchState child(layer_[parent]);
+				child.execute(moves[i]);
+				++threadCounters().generated;
+
+				// Follow the steps back to the initial state
+				if (child.isFinal())
+				{
+					std::vector<SearchAction> solution{SearchAction(moves[i])};
+					std::size_t idx = parent;
+					for (auto d = depth; d > 0; --d)
+					{
+						const auto &step = history_[(d - 1) * beam_width_ + idx];
+						solution.emplace_back(step.move);
+						idx = step.parent;
+					}
+					std::reverse(solution.begin(), solution.end());
+					return solution;
+				}
+
+				if (seen_(child.key()))
+				{
+					++threadCounters().duplicates;
+					continue;
+				}
+
+				Candidate candidate{compute_heuristic(child, *heuristic_), order++, parent, moves[i], child};
+				if (next_.size() < beam_width_)
+				{
+					next_.push_back(candidate);
+					std::push_heap(next_.begin(), next_.end(), better_);
+				}
+				else if (better_(candidate, next_.front()))
+				{
+					std::pop_heap(next_.begin(), next_.end(), better_);
+					next_.back() = candidate;
+					std::push_heap(next_.begin(), next_.end(), better_);
+				}
+			}
+		}
+
+		if (next_.empty())
+		{
+			return giveUp_(Termination::Exhausted);
+		}
+		peak_layer_size_ = std::max(peak_layer_size_, next_.size());
+
+		// The candidates become the next layer
+		layer_.clear();
+		for (std::size_t i = 0; i < next_.size(); ++i)
+		{
+			layer_.push_back(next_[i].state);
+			history_[depth * beam_width_ + i] = {next_[i].parent, next_[i].move};
+		}
+	}
+
+	return giveUp_(Termination::Exhausted);
+}
+
+void BeamSearch::reportStatistics(StrategyEvaluation *report) const
+{
+	report->peak_layer_size = std::max(report->peak_layer_size, peak_layer_size_);
+}
+
+/*************************************************************
+ * IDA STAR *
+ *************************************************************/
+
+static bool onPath(const std::vector<ZobristKey> &path_keys, ZobristKey key)
+{
+	return std::find(path_keys.begin(), path_keys.end(), key) != path_keys.end();
+}
+
+std::vector<SearchAction> IterativeDeepeningAStar::solve(const SearchState &init_state)
+{
+	startLimits_();
+	if (init_state.isFinal())
+	{
+		return {};
+	}
+
+	SearchState state(init_state);
+	path_.clear();
+	path_keys_.assign(1, state.key());
+
+	double bound = compute_heuristic(state, *heuristic_);
+	while (bound != std::numeric_limits<double>::infinity())
+	{
+		bound = search_(state, bound);
+		if (bound < 0)
+		{
+			std::vector<SearchAction> solution;
+			solution.reserve(path_.size());
+			for (const auto &undo : path_)
+			{
+				solution.emplace_back(undo.move);
+			}
+			return solution;
+		}
+	}
+
+	return giveUp_(stopRequested_() ? stopReason_() : Termination::Exhausted);
+}
+
+double IterativeDeepeningAStar::search_(SearchState &state, double bound)
+{
+	if (stopRequested_())
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+
+	double f = path_.size() + compute_heuristic(state, *heuristic_);
+	if (f > bound)
+	{
+		return f;
+	}
+
+	double next_bound = std::numeric_limits<double>::infinity();
+
+	MoveBuffer moves;
+	int nb_moves = state.actions(moves);
+	++threadCounters().expanded;
+	limit_check_.expand();
+	for (int i = 0; i < nb_moves; ++i)
+	{
+		path_.emplace_back();
+		state.make(moves[i], &path_.back());
+		++threadCounters().generated;
+
+		if (state.isFinal())
+		{
+			return -1;
+		}
+
+		// States already on the path only lead to cycles
+		if (onPath(path_keys_, state.key()))
+		{
+			++threadCounters().duplicates;
+		}
+		else
+		{
+			path_keys_.push_back(state.key());
+			auto t = search_(state, bound);
+			if (t < 0 || stopRequested_())
+			{
+				return t;
+			}
+			next_bound = std::min(next_bound, t);
+			path_keys_.pop_back();
+		}
+
+		state.unmake(path_.back());
+		path_.pop_back();
 	}
 
-	return {};
+	return next_bound;
 }
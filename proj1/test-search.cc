@@ -0,0 +1,923 @@
+#include "catch.hpp"
+
+#include "game.h"
+#include "node-arena.h"
+#include "packed-state.h"
+#include "search-interface.h"
+#include "search-strategies.h"
+#include "transposition-table.h"
+#include "memory-budget.h"
+#include "bucket-queue.h"
+#include "corpus.h"
+#include "results-sink.h"
+#include "memusage.h"
+#include "zobrist.h"
+
+#include <sstream>
+#include <malloc.h>
+#include <thread>
+
+std::string gameStateRepresentation(const GameState &gs) {
+	std::stringstream ss;
+	ss << gs;
+	return ss.str();
+}
+
+TEST_CASE("Card packing") {
+	REQUIRE(packCard({Color::Heart, 1}) == 0);
+	REQUIRE(packCard({Color::Spade, king_value}) == nb_cards - 1);
+
+	for (PackedCard card = 0; card < nb_cards; ++card)
+		REQUIRE(packCard(unpackCard(card)) == card);
+}
+
+TEST_CASE("Card tables agree with the storage rules") {
+	for (CardIndex b = 0; b < nb_card_indices; ++b) {
+		Card base = unpackCard(b);
+		REQUIRE(renderColor(base.color) == render_color_map.at(base.color));
+		for (CardIndex c = 0; c < nb_card_indices; ++c) {
+			Card candidate = unpackCard(c);
+			bool stack_fit = candidate.value == base.value - 1 &&
+				render_color_map.at(candidate.color) != render_color_map.at(base.color);
+			bool home_fit = candidate.color == base.color && candidate.value == base.value + 1;
+			REQUIRE(WorkStack::canSitOn(base, candidate) == stack_fit);
+			REQUIRE(HomeDestination::canSitOn(base, candidate) == home_fit);
+		}
+	}
+}
+
+TEST_CASE("Location indices") {
+	for (int loc_idx = 0; loc_idx < nb_locs; ++loc_idx)
+		REQUIRE(locIndex(locFromIndex(loc_idx)) == loc_idx);
+
+	REQUIRE(locIndex({LocationClass::FreeCells, 3}) == 3);
+	REQUIRE(locIndex({LocationClass::Stacks, 0}) == first_stack_loc);
+	REQUIRE(locIndex({LocationClass::Homes, 0}) == first_home_loc);
+}
+
+TEST_CASE("PackedState round trip") {
+	EasyProducer easy(42, 30);
+	RandomProducer random(42);
+
+	for (int i = 0; i < 10; ++i) {
+		for (const auto &gs : {easy.produce(), random.produce()}) {
+			PackedState packed(gs);
+			REQUIRE(packed.toGameState() == gs);
+			REQUIRE(gameStateRepresentation(packed.toGameState()) == gameStateRepresentation(gs));
+		}
+	}
+}
+
+TEST_CASE("Static and virtual move legality agree") {
+	EasyProducer easy(5, 30);
+
+	for (int i = 0; i < 10; ++i) {
+		auto gs = easy.produce();
+		for (auto &from : gs.stacks) {
+			for (auto &to : gs.stacks)
+				REQUIRE(moveLegal(&from, &to) == moveLegal(static_cast<const CardStorage *>(&from), &to));
+			for (auto &to : gs.homes)
+				REQUIRE(moveLegal(&from, &to) == moveLegal(static_cast<const CardStorage *>(&from), &to));
+			for (auto &to : gs.free_cells)
+				REQUIRE(moveLegal(&from, &to) == moveLegal(static_cast<const CardStorage *>(&from), &to));
+		}
+	}
+}
+
+TEST_CASE("Inline cascade storage compares like a vector of cards") {
+	RandomProducer random(11);
+
+	for (int i = 0; i < 10; ++i) {
+		auto gs = random.produce();
+		for (const auto &lhs : gs.stacks) {
+			std::vector<Card> lhs_cards(lhs.storage().begin(), lhs.storage().end());
+			REQUIRE(lhs_cards.size() == lhs.nbCards());
+			for (const auto &rhs : gs.stacks) {
+				std::vector<Card> rhs_cards(rhs.storage().begin(), rhs.storage().end());
+				REQUIRE((lhs < rhs) == (lhs_cards < rhs_cards));
+				REQUIRE((lhs == rhs) == (lhs_cards == rhs_cards));
+			}
+		}
+	}
+}
+
+TEST_CASE("Student heuristic copes with an empty first stack") {
+	RandomProducer random(11);
+	auto gs = random.produce();
+	auto first_card = gs.stacks[0].getCard();
+	while (gs.stacks[0].getCard())
+		;
+	REQUIRE(gs.stacks[0].storage().empty());
+
+	StudentHeuristic student;
+	auto h = student.distanceLowerBound(gs);
+	// a taken free cell counts once
+	gs.free_cells[0].acceptCard(*first_card);
+	REQUIRE(student.distanceLowerBound(gs) == Approx(h + 1.0));
+}
+
+TEST_CASE("PackedState moves match GameState moves") {
+	EasyProducer easy(7, 40);
+
+	for (int i = 0; i < 10; ++i) {
+		auto gs = easy.produce();
+		PackedState packed(gs);
+
+		for (int from = 0; from < nb_non_home_locs; ++from) {
+			for (int to = 0; to < nb_locs; ++to) {
+				auto from_ptr = gs.all_storage[from];
+				auto to_ptr = gs.all_storage[to];
+				REQUIRE(packed.moveLegal(from, to) == moveLegal(from_ptr, to_ptr));
+
+				if (!packed.moveLegal(from, to))
+					continue;
+
+				GameState moved(gs);
+				move(moved.all_storage[from], moved.all_storage[to]);
+				PackedState packed_moved(packed);
+				packed_moved.move(from, to);
+
+				REQUIRE(packed_moved == PackedState(moved));
+				REQUIRE(packed_moved.toGameState() == moved);
+			}
+		}
+	}
+}
+
+TEST_CASE("PackedState is final only with all kings home") {
+	GameState gs;
+	for (int i = 0; i < nb_homes; ++i) {
+		for (int value = 1; value <= king_value; ++value)
+			gs.homes[i].acceptCard({colors_list[i], value});
+	}
+
+	REQUIRE(PackedState(gs).isFinal());
+	REQUIRE_FALSE(PackedState(GameState()).isFinal());
+
+	gs.free_cells[0].acceptCard(*gs.homes[2].getCard());
+	REQUIRE_FALSE(PackedState(gs).isFinal());
+}
+
+TEST_CASE("Move generator matches availableMoves") {
+	EasyProducer easy(3, 35);
+	RandomProducer random(3);
+
+	for (int i = 0; i < 10; ++i) {
+		for (const auto &gs : {easy.produce(), random.produce()}) {
+			auto raw_moves = availableMoves(
+				gs.non_homes.begin(),
+				gs.non_homes.end(),
+				gs.all_storage.begin(),
+				gs.all_storage.end()
+			);
+
+			MoveBuffer moves;
+			auto nb_moves = PackedState(gs).legalMoves(moves);
+			REQUIRE(nb_moves == static_cast<int>(raw_moves.size()));
+
+			for (int j = 0; j < nb_moves; ++j) {
+				REQUIRE(locFromIndex(moves[j].from()) == locFromPtr(gs, raw_moves[j].first));
+				REQUIRE(locFromIndex(moves[j].to()) == locFromPtr(gs, raw_moves[j].second));
+			}
+
+			auto actions = SearchState(gs).actions();
+			REQUIRE(actions.size() == raw_moves.size());
+		}
+	}
+}
+
+TEST_CASE("Incremental Zobrist key matches full recomputation") {
+	EasyProducer easy(11, 35);
+	std::default_random_engine rng(11);
+
+	for (int i = 0; i < 10; ++i) {
+		SearchState state(easy.produce());
+		REQUIRE(state.key() == zobristKey(PackedState(state.gameState())));
+
+		for (int depth = 0; depth < 50 && !state.isFinal(); ++depth) {
+			MoveBuffer moves;
+			auto nb_moves = state.actions(moves);
+			if (nb_moves == 0)
+				break;
+
+			auto pick = std::uniform_int_distribution<int>(0, nb_moves - 1)(rng);
+			REQUIRE(state.execute(moves[pick]));
+			REQUIRE(state.key() == zobristKey(PackedState(state.gameState())));
+		}
+	}
+}
+
+TEST_CASE("Zobrist keys tell free cells apart") {
+	GameState a, b;
+	a.free_cells[0].acceptCard({Color::Heart, 5});
+	a.free_cells[1].acceptCard({Color::Spade, 5});
+	b.free_cells[0].acceptCard({Color::Spade, 5});
+	b.free_cells[1].acceptCard({Color::Heart, 5});
+
+	REQUIRE(zobristKey(PackedState(a)) != zobristKey(PackedState(b)));
+	REQUIRE(zobristKey(PackedState(a)) != zobristKey(PackedState(GameState())));
+	REQUIRE(zobristKey(PackedState(GameState())) == 0);
+}
+
+TEST_CASE("Canonical form collapses permuted locations") {
+	EasyProducer easy(5, 30);
+	auto gs = easy.produce();
+	gs.free_cells[1].acceptCard(*gs.stacks[0].getCard());
+	gs.free_cells[3].acceptCard(*gs.stacks[2].getCard());
+
+	GameState permuted(gs);
+	std::swap(permuted.stacks[0], permuted.stacks[5]);
+	std::swap(permuted.stacks[2], permuted.stacks[7]);
+	std::swap(permuted.homes[0], permuted.homes[3]);
+	permuted.free_cells[0] = permuted.free_cells[1];
+	permuted.free_cells[1].getCard();
+
+	PackedState a(gs), b(permuted);
+	REQUIRE(a != b);
+	REQUIRE(a.canonical().state == b.canonical().state);
+	REQUIRE(zobristKey(a) != zobristKey(b));
+	REQUIRE(canonicalKey(a) == canonicalKey(b));
+	REQUIRE(canonicalKey(a) == canonicalKey(a.canonical().state));
+
+	SearchOptions canonical_mode;
+	canonical_mode.canonical = true;
+	REQUIRE(SearchState(gs, canonical_mode) == SearchState(permuted, canonical_mode));
+	REQUIRE_FALSE(SearchState(gs) == SearchState(permuted));
+
+	auto form = b.canonical();
+	for (int i = 0; i < nb_locs; ++i)
+		REQUIRE(form.state.topCard(i) == b.topCard(form.real_loc[i]));
+}
+
+TEST_CASE("Canonical moves map back to the same real moves") {
+	EasyProducer easy(29, 30);
+	int nb_super_moves = 0;
+
+	for (int i = 0; i < 20; ++i) {
+		PackedState real(easy.produce());
+		auto form = real.canonical();
+
+		MoveBuffer moves;
+		int nb_moves = form.state.legalMoves(moves, true);
+		for (int m = 0; m < nb_moves; ++m) {
+			auto move = form.realMove(moves[m]);
+			REQUIRE(move.count() == moves[m].count());
+
+			auto canonical_after = form.state;
+			auto real_after = real;
+			if (move.count() > 1) {
+				++nb_super_moves;
+				REQUIRE(real.superMoveLegal(move.from(), move.to(), move.count()));
+				canonical_after.moveRun(moves[m].from(), moves[m].to(), moves[m].count());
+				real_after.moveRun(move.from(), move.to(), move.count());
+			} else {
+				REQUIRE(real.moveLegal(move.from(), move.to()));
+				canonical_after.move(moves[m].from(), moves[m].to());
+				real_after.move(move.from(), move.to());
+			}
+			REQUIRE(canonical_after.canonical().state == real_after.canonical().state);
+		}
+	}
+	REQUIRE(nb_super_moves > 0);
+}
+
+TEST_CASE("Incremental canonical key matches full recomputation") {
+	EasyProducer easy(13, 35);
+	std::default_random_engine rng(13);
+	SearchOptions canonical_mode;
+	canonical_mode.canonical = true;
+
+	for (int i = 0; i < 10; ++i) {
+		SearchState state(easy.produce(), canonical_mode);
+		REQUIRE(state.key() == canonicalKey(PackedState(state.gameState())));
+
+		for (int depth = 0; depth < 50 && !state.isFinal(); ++depth) {
+			MoveBuffer moves;
+			auto nb_moves = state.actions(moves);
+			if (nb_moves == 0)
+				break;
+
+			auto pick = std::uniform_int_distribution<int>(0, nb_moves - 1)(rng);
+			REQUIRE(state.execute(moves[pick]));
+			REQUIRE(state.key() == canonicalKey(PackedState(state.gameState())));
+		}
+	}
+}
+
+// the reference: the first safe move of game.cc until none is left
+static void runSafeHomeMoves(GameState &gs) {
+	for (auto moves = safeHomeMoves(gs); !moves.empty(); moves = safeHomeMoves(gs)) {
+		auto from = locIndex(locFromPtr(gs, moves[0].first));
+		auto to = locIndex(locFromPtr(gs, moves[0].second));
+		move(gs.all_storage[from], gs.all_storage[to]);
+	}
+}
+
+TEST_CASE("Automatic moves match safeHomeMoves") {
+	EasyProducer easy(43, 40);
+	std::default_random_engine rng(43);
+
+	for (int i = 0; i < 30; ++i) {
+		GameState gs = easy.produce();
+		SearchState state(gs);
+
+		for (int depth = 0; depth < 80 && !state.isFinal(); ++depth) {
+			MoveBuffer moves;
+			auto nb_moves = state.actions(moves);
+			if (nb_moves == 0)
+				break;
+
+			auto pick = std::uniform_int_distribution<int>(0, nb_moves - 1)(rng);
+			REQUIRE(state.execute(moves[pick]));
+
+			move(gs.all_storage[moves[pick].from()], gs.all_storage[moves[pick].to()]);
+			runSafeHomeMoves(gs);
+			REQUIRE(state.gameState() == gs);
+		}
+	}
+}
+
+TEST_CASE("Unmake restores the state and the key") {
+	EasyProducer easy(19, 35);
+	std::default_random_engine rng(19);
+	int nb_auto_moves = 0;
+
+	for (bool canonical : {false, true}) {
+		SearchOptions options;
+		options.canonical = canonical;
+
+		for (int i = 0; i < 10; ++i) {
+			SearchState state(easy.produce(), options);
+			std::vector<UndoRecord> undo_log;
+			std::vector<std::string> representations;
+			std::vector<ZobristKey> keys;
+
+			for (int depth = 0; depth < 50 && !state.isFinal(); ++depth) {
+				MoveBuffer moves;
+				auto nb_moves = state.actions(moves);
+				if (nb_moves == 0)
+					break;
+
+				representations.push_back(gameStateRepresentation(state.gameState()));
+				keys.push_back(state.key());
+
+				auto pick = std::uniform_int_distribution<int>(0, nb_moves - 1)(rng);
+				undo_log.emplace_back();
+				REQUIRE(state.make(moves[pick], &undo_log.back()));
+				nb_auto_moves += undo_log.back().nb_auto_moves;
+			}
+
+			while (!undo_log.empty()) {
+				state.unmake(undo_log.back());
+				undo_log.pop_back();
+				REQUIRE(gameStateRepresentation(state.gameState()) == representations.back());
+				REQUIRE(state.key() == keys.back());
+				representations.pop_back();
+				keys.pop_back();
+			}
+		}
+	}
+
+	REQUIRE(nb_auto_moves > 0);
+}
+
+TEST_CASE("Super-moves keep keys and undo consistent") {
+	EasyProducer easy(41, 60);
+	std::default_random_engine rng(41);
+	int nb_super_moves = 0;
+
+	for (bool canonical : {false, true}) {
+		SearchOptions options;
+		options.canonical = canonical;
+		options.supermoves = true;
+
+		for (int i = 0; i < 20; ++i) {
+			SearchState state(easy.produce(), options);
+
+			for (int depth = 0; depth < 60 && !state.isFinal(); ++depth) {
+				MoveBuffer moves;
+				auto nb_moves = state.actions(moves);
+				if (nb_moves == 0)
+					break;
+
+				// prefer super-moves to cover them
+				auto pick = std::uniform_int_distribution<int>(0, nb_moves - 1)(rng);
+				for (int j = 0; j < nb_moves; ++j)
+					if (moves[j].count() > 1)
+						pick = j;
+
+				auto before = gameStateRepresentation(state.gameState());
+				auto key = state.key();
+				UndoRecord undo;
+				REQUIRE(state.make(moves[pick], &undo));
+				auto expected = canonical ? canonicalKey(PackedState(state.gameState())) : zobristKey(PackedState(state.gameState()));
+				REQUIRE(state.key() == expected);
+
+				if (moves[pick].count() > 1) {
+					++nb_super_moves;
+					SearchState copy(state);
+					copy.unmake(undo);
+					REQUIRE(gameStateRepresentation(copy.gameState()) == before);
+					REQUIRE(copy.key() == key);
+
+					SearchState replay(copy);
+					REQUIRE(replay.execute(SearchAction(moves[pick])));
+					REQUIRE(replay == state);
+				}
+			}
+		}
+	}
+
+	REQUIRE(nb_super_moves > 0);
+}
+
+TEST_CASE("Super-move capacity follows free cells and empty stacks") {
+	GameState gs;
+	gs.stacks[0].forceCard({Color::Spade, 9});
+	gs.stacks[0].forceCard({Color::Heart, 8});
+	gs.stacks[0].forceCard({Color::Club, 7});
+	gs.stacks[0].forceCard({Color::Diamond, 6});
+	gs.stacks[1].forceCard({Color::Club, 9});
+	for (int s = 2; s < nb_stacks; ++s)
+		gs.stacks[s].forceCard({Color::Spade, s});
+	gs.free_cells[0].acceptCard({Color::Club, 2});
+	gs.free_cells[1].acceptCard({Color::Club, 3});
+
+	auto from = first_stack_loc;
+	auto to = first_stack_loc + 1;
+	PackedState state(gs);
+	REQUIRE(state.runLength(from) == 4);
+	REQUIRE(state.superMoveCapacity(to) == 3);
+	REQUIRE(state.superMoveLegal(from, to, 3));
+	REQUIRE_FALSE(state.superMoveLegal(from, to, 2));
+
+	gs.free_cells[2].acceptCard({Color::Club, 4});
+	PackedState crowded(gs);
+	REQUIRE(crowded.superMoveCapacity(to) == 2);
+	REQUIRE_FALSE(crowded.superMoveLegal(from, to, 3));
+
+	state.moveRun(from, to, 3);
+	REQUIRE(state.stackSize(0) == 1);
+	REQUIRE(state.stackSize(1) == 4);
+	REQUIRE(state.topCard(to) == packCard({Color::Diamond, 6}));
+}
+
+TEST_CASE("Node arena keeps nodes in place across chunks") {
+	NodeArena<std::uint64_t> arena;
+
+	for (std::uint64_t i = 0; i < 200'000; ++i)
+		REQUIRE(arena.push(i) == i);
+
+	auto &first = arena[0];
+	arena.push(42);
+	REQUIRE(&first == &arena[0]);
+	REQUIRE(arena[150'000] == 150'000);
+
+	arena.truncate(10);
+	REQUIRE(arena.size() == 10);
+	REQUIRE(arena.push(7) == 10);
+
+	auto capacity = arena.capacityBytes();
+	arena.clear();
+	REQUIRE(arena.size() == 0);
+	REQUIRE(arena.capacityBytes() == capacity);
+}
+
+TEST_CASE("Solution path follows parent links") {
+	EasyProducer easy(17, 10);
+	SearchState root(easy.produce());
+	NodeArena<SearchNode> arena;
+
+	auto idx = arena.push({root, no_node, 0, {}});
+	std::vector<PackedMove> played;
+	for (int depth = 0; depth < 5; ++depth) {
+		MoveBuffer moves;
+		auto nb_moves = arena[idx].state.actions(moves);
+		if (nb_moves == 0)
+			break;
+
+		SearchNode child = arena[idx];
+		child.state.execute(moves[0]);
+		child.parent = idx;
+		child.action = moves[0];
+		idx = arena.push(child);
+		played.push_back(moves[0]);
+	}
+
+	auto path = solutionPath(arena, idx);
+	REQUIRE(path.size() == played.size());
+
+	SearchState replay(root);
+	for (const auto &action : path)
+		REQUIRE(replay.execute(action));
+	REQUIRE(replay == arena[idx].state);
+}
+
+TEST_CASE("Transposition table lookups and generations") {
+	TranspositionTable table(1 << 12, ReplacementPolicy::TwoTier);
+
+	REQUIRE_FALSE(table.contains(42, 5));
+	table.store(42, 5);
+	REQUIRE(table.contains(42, 5));
+	REQUIRE(table.contains(42, 6));
+	REQUIRE_FALSE(table.contains(42, 4));
+
+	table.store(42, 3);
+	REQUIRE(table.contains(42, 4));
+	REQUIRE(table.stats().hits == 3);
+	REQUIRE(table.stats().misses == 2);
+
+	table.clear();
+	REQUIRE_FALSE(table.contains(42, 10));
+	REQUIRE(table.stats().hits == 0);
+}
+
+TEST_CASE("Transposition table replacement policies") {
+	// a single bucket of two slots, keys all collide
+	auto fill = [](ReplacementPolicy policy) {
+		TranspositionTable table(0, policy);
+		REQUIRE(table.nbEntries() == 2);
+		table.store(1, 2);
+		table.store(2, 8);
+		table.store(3, 5);
+		return table;
+	};
+
+	auto always = fill(ReplacementPolicy::AlwaysReplace);
+	REQUIRE(always.contains(3, 5));
+	REQUIRE(always.contains(2, 8));
+	REQUIRE_FALSE(always.contains(1, 2));
+	REQUIRE(always.stats().evictions == 1);
+
+	auto depth = fill(ReplacementPolicy::DepthPreferred);
+	REQUIRE(depth.contains(1, 2));
+	REQUIRE(depth.contains(3, 5));
+	REQUIRE_FALSE(depth.contains(2, 8));
+	depth.store(4, 9);
+	REQUIRE_FALSE(depth.contains(4, 9));
+	REQUIRE(depth.stats().evictions == 1);
+
+	auto two_tier = fill(ReplacementPolicy::TwoTier);
+	REQUIRE(two_tier.contains(1, 2));
+	REQUIRE(two_tier.contains(3, 5));
+	two_tier.store(4, 9);
+	REQUIRE(two_tier.contains(1, 2));
+	REQUIRE(two_tier.contains(4, 9));
+	REQUIRE(two_tier.stats().evictions == 2);
+
+	REQUIRE(replacementPolicyFromName("two_tier") == ReplacementPolicy::TwoTier);
+	REQUIRE_THROWS(replacementPolicyFromName("lru"));
+}
+
+TEST_CASE("Bucket queue pops by f, then h, then last in") {
+	BucketQueue<int> queue;
+	queue.push(5, 2, 1);
+	queue.push(3, 3, 2);
+	queue.push(3, 1, 3);
+	queue.push(3, 1, 4);
+	queue.push(7, 0, 5);
+	REQUIRE(queue.size() == 5);
+
+	REQUIRE(queue.pop() == 4);
+	REQUIRE(queue.pop() == 3);
+	queue.push(2, 2, 6);
+	REQUIRE(queue.pop() == 6);
+	REQUIRE(queue.pop() == 2);
+	REQUIRE(queue.pop() == 1);
+	REQUIRE(queue.pop() == 5);
+	REQUIRE(queue.empty());
+
+	queue.push(1, 0, 7);
+	queue.clear();
+	REQUIRE(queue.empty());
+	queue.push(4, 4, 8);
+	REQUIRE(queue.pop() == 8);
+}
+
+TEST_CASE("Memory budget accounts charges between RSS checks") {
+	auto rss = getCurrentRSS();
+	MemoryBudget budget(rss + 1'000'000, 0, 1'000'000);
+
+	REQUIRE_FALSE(budget.exceeded());
+	budget.charge(600'000);
+	REQUIRE_FALSE(budget.exceeded());
+	budget.charge(600'000);
+	REQUIRE(budget.exceeded());
+	budget.release(600'000);
+	REQUIRE_FALSE(budget.exceeded());
+	REQUIRE(budget.peak() >= rss + 1'200'000);
+
+	NodeArena<std::uint64_t> arena(&budget);
+	arena.push(1);
+	REQUIRE(budget.exceeded());
+}
+
+TEST_CASE("Search counters are kept per thread") {
+	EasyProducer easy(5, 10);
+	SearchState root(easy.produce());
+	BreadthFirstSearch bfs(std::size_t{1} << 30);
+
+	threadCounters() = {};
+	bfs.solve(root);
+	auto counters = threadCounters();
+	REQUIRE(counters.expanded > 0);
+	REQUIRE(counters.generated >= counters.expanded);
+	REQUIRE(counters.heuristic_calls == 0);
+
+	SearchCounters other_thread;
+	std::thread worker([&]() {
+		other_thread = threadCounters();
+		bfs.solve(root);
+		other_thread += threadCounters();
+	});
+	worker.join();
+	REQUIRE(other_thread.expanded == counters.expanded);
+	REQUIRE(other_thread.duplicates == counters.duplicates);
+	REQUIRE(threadCounters().expanded == counters.expanded);
+}
+
+// the solution replays from root to a final state
+static void requireSolves(const SearchState &root, const std::vector<SearchAction> &solution) {
+	SearchState replay(root);
+	for (const auto &action : solution)
+		REQUIRE(replay.execute(action));
+	REQUIRE(replay.isFinal());
+}
+
+TEST_CASE("IDA* solves easy deals in place") {
+	EasyProducer easy(11, 12);
+	IterativeDeepeningAStar ida(std::make_unique<OufOfHome_Pseudo>());
+
+	for (int i = 0; i < 5; ++i) {
+		SearchState root(easy.produce());
+		auto solution = ida.solve(root);
+
+		requireSolves(root, solution);
+	}
+}
+
+TEST_CASE("HDA* rebuilds solutions across owners") {
+	EasyProducer easy(23, 20);
+	auto mem_limit = std::size_t{1} << 30;
+	HashDistributedAStar hda(std::make_unique<OufOfHome_Pseudo>(), mem_limit, defaultTableConfig(mem_limit), 3);
+
+	for (int i = 0; i < 5; ++i) {
+		SearchState root(easy.produce());
+		auto solution = hda.solve(root);
+
+		requireSolves(root, solution);
+	}
+
+	StrategyEvaluation report;
+	hda.reportStatistics(&report);
+	REQUIRE(report.workers.size() == 3);
+}
+
+TEST_CASE("Portfolio returns a solution and stops the losers") {
+	EasyProducer easy(29, 15);
+	auto mem_limit = std::size_t{1} << 29;
+
+	std::vector<std::unique_ptr<SearchStrategyItf>> strategies;
+	strategies.push_back(std::make_unique<AStarSearch>(std::make_unique<OufOfHome_Pseudo>(), mem_limit));
+	strategies.push_back(std::make_unique<DepthFirstSearch>(1'000'000, mem_limit));
+	PortfolioSearch portfolio(std::move(strategies), PortfolioSearch::Pick::First, std::chrono::milliseconds(0));
+
+	SearchState root(easy.produce());
+	auto solution = portfolio.solve(root);
+	requireSolves(root, solution);
+
+	// a full random deal is out of reach of BFS
+	std::vector<std::unique_ptr<SearchStrategyItf>> blind;
+	blind.push_back(std::make_unique<BreadthFirstSearch>(mem_limit));
+	PortfolioSearch deadline(std::move(blind), PortfolioSearch::Pick::Shortest, std::chrono::milliseconds(100));
+
+	RandomProducer random(3);
+	auto t0 = std::chrono::steady_clock::now();
+	REQUIRE(deadline.solve(SearchState(random.produce())).empty());
+	REQUIRE(std::chrono::steady_clock::now() - t0 < std::chrono::seconds(5));
+	REQUIRE(deadline.termination() == Termination::Timeout);
+}
+
+TEST_CASE("Portfolio members share the whole memory limit") {
+	const std::size_t nb_members = 3;
+	const auto headroom = std::size_t{300} << 20;
+	malloc_trim(0);
+	auto mem_limit = getCurrentRSS() + default_memory_reserve + headroom;
+
+	// as fc-sui builds it: the whole limit for every member, tables split
+	std::vector<std::unique_ptr<SearchStrategyItf>> strategies;
+	for (std::size_t i = 0; i < nb_members; ++i) {
+		TableConfig table{mem_limit / tt_memory_divisor / nb_members, ReplacementPolicy::TwoTier};
+		strategies.push_back(std::make_unique<BreadthFirstSearch>(mem_limit, table));
+	}
+	PortfolioSearch portfolio(std::move(strategies), PortfolioSearch::Pick::First, std::chrono::milliseconds(0));
+
+	RandomProducer random(1);
+	SearchState root(random.produce());
+	auto rss_before = getCurrentRSS();
+	resetPeakRSS();
+	REQUIRE(portfolio.solve(root).empty());
+	REQUIRE(portfolio.termination() == Termination::MemLimit);
+	// well beyond a share of headroom / nb_members each
+	REQUIRE(getPeakRSSSinceReset() > rss_before + 2 * headroom / nb_members);
+}
+
+TEST_CASE("ARA* only reports shorter and shorter solutions") {
+	EasyProducer easy(31, 35);
+	auto mem_limit = std::size_t{1} << 29;
+	AnytimeAStar ara(std::make_unique<OufOfHome_Pseudo>(), mem_limit, defaultTableConfig(mem_limit), 5.0, 1.0, std::chrono::milliseconds(2000));
+
+	for (int i = 0; i < 3; ++i) {
+		SearchState root(easy.produce());
+		auto solution = ara.solve(root);
+
+		requireSolves(root, solution);
+
+		StrategyEvaluation report;
+		ara.reportStatistics(&report);
+		REQUIRE_FALSE(report.improvements.empty());
+		for (std::size_t j = 1; j < report.improvements.size(); ++j) {
+			REQUIRE(report.improvements[j].length < report.improvements[j-1].length);
+			REQUIRE(report.improvements[j].time >= report.improvements[j-1].time);
+		}
+		REQUIRE(report.improvements.back().length == solution.size());
+	}
+}
+
+TEST_CASE("ARA* returns its best solution at the per-deal time limit") {
+	EasyProducer easy(31, 45);
+	auto mem_limit = std::size_t{1} << 29;
+	AnytimeAStar ara(std::make_unique<StudentHeuristic>(), mem_limit, defaultTableConfig(mem_limit), 5.0, 0.5, std::chrono::milliseconds(0));
+	ara.setLimits({std::chrono::milliseconds(300), 0});
+
+	SearchState root(easy.produce());
+	auto t0 = std::chrono::steady_clock::now();
+	auto solution = ara.solve(root);
+	auto took = std::chrono::steady_clock::now() - t0;
+
+	// still improving when the time is up
+	REQUIRE(took >= std::chrono::milliseconds(300));
+	REQUIRE(took < std::chrono::seconds(5));
+	requireSolves(root, solution);
+}
+
+TEST_CASE("Beam search stays within its width") {
+	EasyProducer easy(37, 25);
+	BeamSearch beam(std::make_unique<OufOfHome_Pseudo>(), 50, 200);
+
+	for (int i = 0; i < 5; ++i) {
+		SearchState root(easy.produce());
+		auto solution = beam.solve(root);
+
+		requireSolves(root, solution);
+
+		StrategyEvaluation report;
+		beam.reportStatistics(&report);
+		REQUIRE(report.peak_layer_size > 0);
+		REQUIRE(report.peak_layer_size <= 50);
+	}
+}
+
+TEST_CASE("Beam search of width one follows a single line") {
+	EasyProducer easy(37, 10);
+	BeamSearch beam(std::make_unique<OufOfHome_Pseudo>(), 1, 200);
+
+	for (int i = 0; i < 5; ++i) {
+		SearchState root(easy.produce());
+		auto solution = beam.solve(root);
+
+		requireSolves(root, solution);
+
+		StrategyEvaluation report;
+		beam.reportStatistics(&report);
+		REQUIRE(report.peak_layer_size <= 1);
+	}
+}
+
+TEST_CASE("Corpus results round trip and regressions are flagged") {
+	std::vector<CorpusRecord> baseline;
+	for (unsigned long deal = 0; deal < 10; ++deal) {
+		DealRecord record;
+		record.deal = deal;
+		record.solved = true;
+		record.solution_length = 20 + deal;
+		record.expanded = 1000 * (deal + 1);
+		record.time = std::chrono::microseconds(5000 + deal);
+		record.peak_rss = 1 << 20;
+		baseline.push_back({"easy-20", record});
+	}
+
+	std::stringstream file;
+	writeCorpusResults(file, baseline);
+	auto read_back = readCorpusResults(file);
+	REQUIRE(read_back.size() == baseline.size());
+	REQUIRE(read_back[3].set == "easy-20");
+	REQUIRE(read_back[3].record.expanded == baseline[3].record.expanded);
+	REQUIRE(read_back[3].record.time == baseline[3].record.time);
+
+	std::stringstream report;
+	REQUIRE(compareToBaseline(report, baseline, read_back) == 0);
+
+	auto slower = baseline;
+	for (auto &entry : slower)
+		entry.record.expanded += entry.record.expanded / 5 + entry.record.deal;
+	slower[9].record.solved = false;
+	REQUIRE(compareToBaseline(report, baseline, slower) == 2);
+
+	// the same number of solved deals, but not the same deals
+	auto partly_unsolved = baseline;
+	partly_unsolved[0].record.solved = false;
+	auto swapped = baseline;
+	swapped[1].record.solved = false;
+	std::stringstream swap_report;
+	REQUIRE(compareToBaseline(swap_report, partly_unsolved, swapped) == 1);
+	REQUIRE(swap_report.str().find("9 -> 9 of 10 deals (1 lost, 1 gained)\tREGRESSION") != std::string::npos);
+
+	std::stringstream garbage("not a results file\n");
+	REQUIRE_THROWS_AS(readCorpusResults(garbage), std::runtime_error);
+}
+
+TEST_CASE("Strategies tell why they gave up") {
+	RandomProducer random(8);
+	SearchState root(random.produce());
+
+	auto mem_limit = std::size_t{64} << 20;
+	BreadthFirstSearch bfs(mem_limit, defaultTableConfig(mem_limit));
+	REQUIRE(bfs.solve(root).empty());
+	REQUIRE(bfs.termination() == Termination::MemLimit);
+
+	StopSource stop;
+	stop.requestStop();
+	DummySearch dummy(10, 10);
+	dummy.setStopToken(stop.token());
+	REQUIRE(dummy.solve(root).empty());
+	REQUIRE(dummy.termination() == Termination::Timeout);
+}
+
+TEST_CASE("Results sink writes one record per deal") {
+	DealRecord solved;
+	solved.deal = 0;
+	solved.solved = true;
+	solved.termination = Termination::Solved;
+	solved.solution_length = 12;
+	solved.expanded = 40;
+	solved.generated = 400;
+	solved.time = std::chrono::microseconds(1500);
+	solved.peak_rss = 1 << 20;
+
+	DealRecord failed;
+	failed.deal = 1;
+	failed.termination = Termination::MemLimit;
+
+	RunDescription run{7, "a_star", "student"};
+
+	std::stringstream jsonl;
+	ResultsSink(jsonl, ResultsSink::Format::JsonLines, run).write("easy-20", {solved, failed});
+	std::string line;
+	REQUIRE(std::getline(jsonl, line));
+	REQUIRE(line == "{\"seed\": 7, \"set\": \"easy-20\", \"deal\": 0, \"solver\": \"a_star\", \"heuristic\": \"student\", "
+		"\"solved\": true, \"length\": 12, \"expanded\": 40, \"generated\": 400, \"time_us\": 1500, "
+		"\"peak_rss\": 1048576, \"termination\": \"solved\"}");
+	REQUIRE(std::getline(jsonl, line));
+	REQUIRE(line.find("\"termination\": \"mem-limit\"") != std::string::npos);
+
+	std::stringstream csv;
+	ResultsSink sink(csv, ResultsSink::Format::Csv, run);
+	sink.write("easy-20", {solved});
+	sink.write("random", {failed});
+	REQUIRE(csv.str() ==
+		"seed,set,deal,solver,heuristic,solved,length,expanded,generated,time_us,peak_rss,termination\n"
+		"7,easy-20,0,a_star,student,1,12,40,400,1500,1048576,solved\n"
+		"7,random,1,a_star,student,0,0,0,0,0,0,mem-limit\n");
+
+	StrategyEvaluation report;
+	report.deals = {solved, failed};
+	std::stringstream summary;
+	summary << report;
+	REQUIRE(summary.str().find("Solved 1 / 2") == 0);
+	REQUIRE(summary.str().find("Time p50/p90/p99: 0 / 1500 / 1500 us") != std::string::npos);
+	REQUIRE(summary.str().find("Unsolved: mem-limit 1") != std::string::npos);
+}
+
+TEST_CASE("Time and node limits cut a deal short") {
+	RandomProducer random(8);
+	SearchState root(random.produce());
+
+	AStarSearch a_star(std::make_unique<StudentHeuristic>(), std::size_t{256} << 20);
+	a_star.setLimits({std::chrono::milliseconds(0), 100});
+	threadCounters() = {};
+	REQUIRE(a_star.solve(root).empty());
+	REQUIRE(a_star.termination() == Termination::NodeLimit);
+	REQUIRE(threadCounters().expanded <= 101);
+
+	IterativeDeepeningAStar ida_star(std::make_unique<StudentHeuristic>());
+	ida_star.setLimits({std::chrono::milliseconds(20), 0});
+	auto t0 = std::chrono::steady_clock::now();
+	REQUIRE(ida_star.solve(root).empty());
+	REQUIRE(std::chrono::steady_clock::now() - t0 < std::chrono::seconds(5));
+	REQUIRE(ida_star.termination() == Termination::Timeout);
+
+	// the limits hold for each solve() anew
+	REQUIRE(ida_star.solve(root).empty());
+	REQUIRE(ida_star.termination() == Termination::Timeout);
+}
@@ -0,0 +1,104 @@
+#include "transposition-table.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+ReplacementPolicy replacementPolicyFromName(const std::string &name) {
+    if (name == "depth")
+        return ReplacementPolicy::DepthPreferred;
+    else if (name == "always")
+        return ReplacementPolicy::AlwaysReplace;
+    else if (name == "two_tier")
+        return ReplacementPolicy::TwoTier;
+    else
+        throw std::invalid_argument("Unknown replacement policy '" + name + "', supported are: depth, always, two_tier");
+}
+
+void TranspositionTable::FreeDeleter::operator()(Bucket *buckets) const {
+    std::free(buckets);
+}
+
+TranspositionTable::TranspositionTable(std::size_t nb_bytes, ReplacementPolicy policy) :
+        generation_(1),
+        policy_(policy) {
+    std::size_t nb_buckets = 1;
+    while (2 * nb_buckets * sizeof(Bucket) <= nb_bytes)
+        nb_buckets *= 2;
+    mask_ = nb_buckets - 1;
+
+    // calloc leaves untouched pages unmapped, so the table only costs what gets used
+    buckets_.reset(static_cast<Bucket *>(std::calloc(nb_buckets, sizeof(Bucket))));
+    if (!buckets_)
+        throw std::bad_alloc();
+}
+
+void TranspositionTable::clear() {
+    stats_ = {};
+    if (++generation_ == 0) {
+        std::memset(buckets_.get(), 0, (mask_ + 1) * sizeof(Bucket));
+        generation_ = 1;
+    }
+}
+
+bool TranspositionTable::contains(ZobristKey key, std::uint32_t depth) {
+    for (const auto &entry : bucket_(key).slots) {
+        if (valid_(entry) && entry.key == key && entry.depth <= depth) {
+            ++stats_.hits;
+            return true;
+        }
+    }
+
+    ++stats_.misses;
+    return false;
+}
+
+void TranspositionTable::store(ZobristKey key, std::uint32_t depth) {
+    auto &slots = bucket_(key).slots;
+    Entry entry{key, depth, generation_};
+
+    for (auto &slot : slots) {
+        if (valid_(slot) && slot.key == key) {
+            if (depth < slot.depth)
+                slot.depth = depth;
+            return;
+        }
+    }
+
+    // the slot whose entry gets overwritten
+    Entry *victim = nullptr;
+    switch (policy_) {
+        case ReplacementPolicy::AlwaysReplace:
+            // slot 0 holds the most recent entry, slot 1 the one before
+            std::swap(slots[0], slots[1]);
+            victim = &slots[0];
+            break;
+        case ReplacementPolicy::DepthPreferred:
+            if (!valid_(slots[0]))
+                victim = &slots[0];
+            else if (!valid_(slots[1]))
+                victim = &slots[1];
+            else
+                victim = slots[0].depth >= slots[1].depth ? &slots[0] : &slots[1];
+
+            // both stored states are closer to the root, drop the new one
+            if (valid_(*victim) && depth > victim->depth)
+                return;
+            break;
+        case ReplacementPolicy::TwoTier:
+            // slot 0 is depth-preferred, its previous entry is demoted to slot 1
+            if (!valid_(slots[0]) || depth <= slots[0].depth) {
+                std::swap(slots[0], slots[1]);
+                victim = &slots[0];
+            } else {
+                victim = &slots[1];
+            }
+            break;
+    }
+
+    if (valid_(*victim))
+        ++stats_.evictions;
+    *victim = entry;
+}
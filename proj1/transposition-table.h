@@ -0,0 +1,73 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include "zobrist.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// What happens when both slots of a bucket hold other states:
+// DepthPreferred keeps the entry closer to the root (the bigger subtree),
+// AlwaysReplace keeps the two most recent entries,
+// TwoTier keeps one depth-preferred and one most recent entry.
+enum class ReplacementPolicy {DepthPreferred, AlwaysReplace, TwoTier};
+
+ReplacementPolicy replacementPolicyFromName(const std::string &name) ;
+
+struct TableConfig {
+    std::size_t nb_bytes;
+    ReplacementPolicy policy;
+};
+
+struct TranspositionStats {
+    unsigned long long hits = 0;
+    unsigned long long misses = 0;
+    unsigned long long evictions = 0;
+};
+
+// Fixed-size closed set keyed by Zobrist keys. Only the key is stored, so
+// two states are taken as equal when their 64-bit keys are; with millions of
+// entries the chance of a false match stays around 1e-7.
+class TranspositionTable {
+public:
+    TranspositionTable(std::size_t nb_bytes, ReplacementPolicy policy) ;
+    explicit TranspositionTable(const TableConfig &config) : TranspositionTable(config.nb_bytes, config.policy) {}
+
+    // forgets all entries in O(1) and resets the counters
+    void clear();
+
+    // true if the state has already been stored at the given depth or closer to the root
+    bool contains(ZobristKey key, std::uint32_t depth);
+    void store(ZobristKey key, std::uint32_t depth);
+
+    const TranspositionStats &stats() const { return stats_; }
+    std::size_t nbEntries() const { return 2 * (mask_ + 1); }
+
+private:
+    struct Entry {
+        ZobristKey key;
+        std::uint32_t depth;
+        std::uint32_t generation;
+    };
+
+    struct alignas(2 * sizeof(Entry)) Bucket {
+        Entry slots[2];
+    };
+
+    struct FreeDeleter {
+        void operator()(Bucket *buckets) const;
+    };
+
+    Bucket &bucket_(ZobristKey key) { return buckets_[key & mask_]; }
+    bool valid_(const Entry &entry) const { return entry.generation == generation_; }
+
+    std::unique_ptr<Bucket[], FreeDeleter> buckets_;
+    std::size_t mask_;
+    std::uint32_t generation_;
+    ReplacementPolicy policy_;
+    TranspositionStats stats_;
+};
+
+#endif
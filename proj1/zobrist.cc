@@ -0,0 +1,127 @@
+#include "zobrist.h"
+
+#include <cassert>
+
+// splitmix64, fixed seed so that keys are the same in every run
+static ZobristKey nextKey(std::uint64_t *seed) {
+    std::uint64_t z = (*seed += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+static ZobristTable generateTable() {
+    ZobristTable table;
+    std::uint64_t seed = 0x5eed'f00d'cafe'f1e1;
+
+    for (auto &location : table) {
+        for (auto &depth : location) {
+            for (auto &key : depth)
+                key = nextKey(&seed);
+        }
+    }
+
+    return table;
+}
+
+static CanonicalTable generateCanonicalTable() {
+    CanonicalTable table;
+    std::uint64_t seed = 0xca40'41ca'1f0e'2d5b;
+
+    for (auto &card : table) {
+        for (auto &key : card)
+            key = nextKey(&seed);
+    }
+
+    return table;
+}
+
+const ZobristTable zobrist_table = generateTable();
+const CanonicalTable canonical_table = generateCanonicalTable();
+
+ZobristKey zobristTop(const PackedState &state, int loc_idx) {
+    auto card = state.topCard(loc_idx);
+    if (card == no_card)
+        return 0;
+
+    int depth = 0;
+    if (loc_idx >= first_home_loc)
+        depth = packedValue(card) - 1;
+    else if (loc_idx >= first_stack_loc)
+        depth = state.stackSize(loc_idx - first_stack_loc) - 1;
+
+    assert(depth < zobrist_depths);
+    return zobristSlot(loc_idx, depth, card);
+}
+
+ZobristKey zobristKey(const PackedState &state) {
+    ZobristKey key = 0;
+
+    for (int i = 0; i < nb_freecells; ++i) {
+        if (state.freeCell(i) != no_card)
+            key ^= zobristSlot(i, 0, state.freeCell(i));
+    }
+
+    for (int i = 0; i < nb_stacks; ++i) {
+        int depth = 0;
+        for (auto it = state.stackBegin(i); it != state.stackEnd(i); ++it, ++depth) {
+            assert(depth < zobrist_depths);
+            key ^= zobristSlot(first_stack_loc + i, depth, *it);
+        }
+    }
+
+    for (int i = 0; i < nb_homes; ++i) {
+        auto top = state.homeTop(i);
+        if (top == no_card)
+            continue;
+
+        for (int value = 1; value <= packedValue(top); ++value)
+            key ^= zobristSlot(first_home_loc + i, value - 1, top - packedValue(top) + value);
+    }
+
+    return key;
+}
+
+ZobristKey canonicalTop(const PackedState &state, int loc_idx) {
+    auto card = state.topCard(loc_idx);
+    if (card == no_card)
+        return 0;
+
+    if (loc_idx < first_stack_loc)
+        return canonical_table[card][canonical_free_cell];
+    if (loc_idx >= first_home_loc)
+        return canonical_table[card][canonical_home];
+
+    auto stack_id = loc_idx - first_stack_loc;
+    auto size = state.stackSize(stack_id);
+    auto base = size > 1 ? state.stackBegin(stack_id)[size - 2] : canonical_bottom;
+    return canonical_table[card][base];
+}
+
+ZobristKey canonicalKey(const PackedState &state) {
+    ZobristKey key = 0;
+
+    for (int i = 0; i < nb_freecells; ++i) {
+        if (state.freeCell(i) != no_card)
+            key ^= canonical_table[state.freeCell(i)][canonical_free_cell];
+    }
+
+    for (int i = 0; i < nb_stacks; ++i) {
+        int base = canonical_bottom;
+        for (auto it = state.stackBegin(i); it != state.stackEnd(i); ++it) {
+            key ^= canonical_table[*it][base];
+            base = *it;
+        }
+    }
+
+    for (int i = 0; i < nb_homes; ++i) {
+        auto top = state.homeTop(i);
+        if (top == no_card)
+            continue;
+
+        for (PackedCard card = top - packedValue(top) + 1; card <= top; ++card)
+            key ^= canonical_table[card][canonical_home];
+    }
+
+    return key;
+}
@@ -0,0 +1,41 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "packed-state.h"
+
+#include <array>
+#include <cstdint>
+
+using ZobristKey = std::uint64_t;
+
+// One random key per (location, depth, card) slot. Depth is the position
+// in the cascade for stacks, value - 1 for homes and 0 for free cells.
+inline constexpr int zobrist_depths = max_stack_size;
+using ZobristTable = std::array<std::array<std::array<ZobristKey, nb_cards>, zobrist_depths>, nb_locs>;
+
+extern const ZobristTable zobrist_table;
+
+inline ZobristKey zobristSlot(int loc_idx, int depth, PackedCard card) {
+    return zobrist_table[loc_idx][depth][card];
+}
+
+// Key of the top card of the given location, 0 for an empty one
+ZobristKey zobristTop(const PackedState &state, int loc_idx) ;
+
+// Full recomputation, the search keeps the key up to date incrementally
+ZobristKey zobristKey(const PackedState &state) ;
+
+// Keys invariant to permutations of free cells, stacks and homes.
+// A card in a stack is keyed by the card it sits on (or the bottom),
+// which identifies the set of cascades regardless of their order.
+inline constexpr int canonical_bottom = nb_cards;
+inline constexpr int canonical_free_cell = nb_cards + 1;
+inline constexpr int canonical_home = nb_cards + 2;
+using CanonicalTable = std::array<std::array<ZobristKey, nb_cards + 3>, nb_cards>;
+
+extern const CanonicalTable canonical_table;
+
+ZobristKey canonicalTop(const PackedState &state, int loc_idx) ;
+ZobristKey canonicalKey(const PackedState &state) ;
+
+#endif